@@ -0,0 +1,70 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef ALLOCATION_COUNTER
+namespace {
+	std::atomic<std::size_t> s_uAllocationCount(0);
+	thread_local bool s_bThreadTracked = false;
+
+	void* CountedAllocate(std::size_t uSize) {
+		if (s_bThreadTracked) {
+			s_uAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void* pMemory = std::malloc(uSize ? uSize : 1);
+		if (!pMemory) {
+			throw std::bad_alloc();
+		}
+		return pMemory;
+	}
+}
+
+void* operator new(std::size_t uSize) {
+	return CountedAllocate(uSize);
+}
+
+void* operator new[](std::size_t uSize) {
+	return CountedAllocate(uSize);
+}
+
+void operator delete(void* pMemory) noexcept {
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept {
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, std::size_t) noexcept {
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory, std::size_t) noexcept {
+	std::free(pMemory);
+}
+
+bool AllocationCounter::IsEnabled() {
+	return true;
+}
+
+std::size_t AllocationCounter::GetCount() {
+	return s_uAllocationCount.load(std::memory_order_relaxed);
+}
+
+void AllocationCounter::SetThreadTracked(bool bTracked) {
+	s_bThreadTracked = bTracked;
+}
+#else
+bool AllocationCounter::IsEnabled() {
+	return false;
+}
+
+std::size_t AllocationCounter::GetCount() {
+	return 0;
+}
+
+void AllocationCounter::SetThreadTracked(bool) {
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+// Debug builds replace the global operator new to count heap allocations made by tracked
+// threads, which is how the simulation is checked to run without allocating once warmed up.
+// Worker threads of the JobSystem are always tracked, other threads opt in.
+// Release builds compile none of it and every count stays 0.
+#if defined(_DEBUG) && !defined(ALLOCATION_COUNTER)
+#define ALLOCATION_COUNTER
+#endif
+
+namespace AllocationCounter {
+	bool IsEnabled();
+
+	// Allocations made by tracked threads since the program started
+	std::size_t GetCount();
+
+	void SetThreadTracked(bool bTracked);
+}
@@ -0,0 +1,9 @@
+#include "ArchetypeRegistry.h"
+
+ArchetypeRegistry ArchetypeRegistry::m_Instance;
+
+ArchetypeRegistry::Id ArchetypeRegistry::Register(const Archetype& rArchetype) {
+	assert(m_Archetypes.size() < InvalidId);
+	m_Archetypes.push_back(rArchetype);
+	return (Id)(m_Archetypes.size() - 1);
+}
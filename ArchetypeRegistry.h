@@ -0,0 +1,60 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cassert>
+#include <vector>
+#include "PhysicsWorld.h"
+
+// Gameplay numbers of one entity type. Plain values, so the stats of every type can live in constexpr tables.
+struct ArchetypeStats {
+	int m_iHealth = 0;
+	float m_fSpeed = 0.0f; // Walking speed of enemies, launch speed of projectiles
+	float m_fAngularSpeed = 0.0f;
+	float m_fAttackInterval = 0.0f; // Seconds between two throws of a tower
+	float m_fRange = 0.0f; // How far away a tower picks its targets
+	float m_fLifetime = 0.0f; // Seconds before a projectile disappears, 0 lives until removed
+	int m_iDamage = 0;
+	float m_fKnockback = 0.0f;
+	int m_iGoldReward = 0;
+};
+
+// Immutable per-type data (look, body shape, stats), registered once at startup.
+// Entities only store the id of their archetype next to their own mutable state,
+// so adding types does not make instances bigger and every thread can read the records.
+class ArchetypeRegistry
+{
+public:
+	typedef unsigned short Id;
+	static constexpr Id InvalidId = 0xFFFF;
+
+	struct Archetype {
+		sf::Sprite m_Sprite; // Texture, texture rect, scale and origin, drawn at the position of each instance
+		PhysicsWorld::BodyDef m_BodyDef;
+		ArchetypeStats m_Stats;
+		Id m_ProjectileArchetype = InvalidId; // What a tower throws
+	};
+
+	Id Register(const Archetype& rArchetype);
+
+	const Archetype& Get(Id id) const {
+		assert(id < m_Archetypes.size());
+		return m_Archetypes[id];
+	}
+
+	int GetCount() const {
+		return (int)m_Archetypes.size();
+	}
+
+	// Drawing an entity only knows its id, so the records are reachable from anywhere
+	static const ArchetypeRegistry& getInstanceConst() {
+		return m_Instance;
+	}
+
+	static ArchetypeRegistry& getInstanceNonConst() {
+		return m_Instance;
+	}
+
+private:
+	static ArchetypeRegistry m_Instance;
+
+	std::vector<Archetype> m_Archetypes;
+};
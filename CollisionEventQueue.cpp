@@ -0,0 +1,34 @@
+#include "CollisionEventQueue.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+
+void CollisionEventQueue::SetThreadCount(int iThreadCount) {
+	m_ThreadEvents.resize(iThreadCount);
+}
+
+void CollisionEventQueue::Push(const Event& rEvent) {
+	const int iThreadIndex = JobSystem::GetCurrentThreadIndex();
+	assert(iThreadIndex < (int)m_ThreadEvents.size());
+	m_ThreadEvents[iThreadIndex].push_back(rEvent);
+}
+
+void CollisionEventQueue::Collect(std::vector<Event>& rOutEvents) {
+	rOutEvents.clear();
+	for (std::vector<Event>& rEvents : m_ThreadEvents) {
+		rOutEvents.insert(rOutEvents.end(), rEvents.begin(), rEvents.end());
+		rEvents.clear();
+	}
+
+	std::sort(rOutEvents.begin(), rOutEvents.end(), [](const Event& rA, const Event& rB) {
+		if (rA.m_eKind != rB.m_eKind) return rA.m_eKind < rB.m_eKind;
+		if (rA.m_Target != rB.m_Target) return rA.m_Target < rB.m_Target;
+		return rA.m_Source < rB.m_Source;
+		});
+}
+
+void CollisionEventQueue::Clear() {
+	for (std::vector<Event>& rEvents : m_ThreadEvents) {
+		rEvents.clear();
+	}
+}
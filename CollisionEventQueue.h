@@ -0,0 +1,38 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "PhysicsWorld.h"
+
+// Gameplay reactions to contacts are recorded here instead of being applied on the spot,
+// so contacts can be handled on any thread. Every thread appends to its own buffer and
+// the game resolves all events in one pass after physics.
+class CollisionEventQueue
+{
+public:
+	enum class Kind : unsigned char {
+		ProjectileHitEnemy
+	};
+
+	struct Event {
+		Kind m_eKind;
+		PhysicsWorld::BodyId m_Source; // The body causing the effect, e.g. the projectile
+		PhysicsWorld::BodyId m_Target; // The body receiving it
+		sf::Vector2f m_vNormal; // From source to target
+	};
+
+	// One buffer per JobSystem thread
+	void SetThreadCount(int iThreadCount);
+
+	// Safe to call from any job, uses the buffer of the calling thread
+	void Push(const Event& rEvent);
+
+	// Moves every buffered event into rOutEvents, grouped by kind and target so repeated
+	// hits on the same target are next to each other. The order does not depend on which
+	// thread recorded an event.
+	void Collect(std::vector<Event>& rOutEvents);
+
+	void Clear();
+
+private:
+	std::vector<std::vector<Event>> m_ThreadEvents;
+};
@@ -0,0 +1,241 @@
+#include "CollisionKernels.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COLLISION_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC allows AVX intrinsics in any function, GCC and Clang need them enabled per function
+#define COLLISION_KERNELS_TARGET_AVX2
+#else
+#define COLLISION_KERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+	using CollisionKernels::InstructionSet;
+
+	// Scalar versions, also used for the tail of every SIMD loop
+	int CircleVsCirclesScalar(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pRadius, int iBegin, int iCount, int* pOutHits) {
+		int iHitCount = 0;
+		for (int i = iBegin; i < iCount; i++) {
+			const float fDeltaX = pX[i] - fX;
+			const float fDeltaY = pY[i] - fY;
+			const float fSumOfRadii = pRadius[i] + fRadius;
+			if (fDeltaX * fDeltaX + fDeltaY * fDeltaY < fSumOfRadii * fSumOfRadii) {
+				pOutHits[iHitCount++] = i;
+			}
+		}
+		return iHitCount;
+	}
+
+	int CircleVsRectanglesScalar(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pHalfWidth, const float* pHalfHeight, int iBegin, int iCount, int* pOutHits) {
+		int iHitCount = 0;
+		for (int i = iBegin; i < iCount; i++) {
+			const float fClosestX = std::clamp(fX, pX[i] - pHalfWidth[i], pX[i] + pHalfWidth[i]);
+			const float fClosestY = std::clamp(fY, pY[i] - pHalfHeight[i], pY[i] + pHalfHeight[i]);
+			const float fDeltaX = fClosestX - fX;
+			const float fDeltaY = fClosestY - fY;
+			if (fDeltaX * fDeltaX + fDeltaY * fDeltaY < fRadius * fRadius) {
+				pOutHits[iHitCount++] = i;
+			}
+		}
+		return iHitCount;
+	}
+
+#ifdef COLLISION_KERNELS_X86
+	// Turns a lane mask into hit indices, lowest lane first
+	int WriteHits(int iMask, int iBase, int* pOutHits) {
+		int iHitCount = 0;
+		while (iMask != 0) {
+			int iLane = 0;
+			while ((iMask & (1 << iLane)) == 0) {
+				iLane++;
+			}
+			pOutHits[iHitCount++] = iBase + iLane;
+			iMask &= iMask - 1;
+		}
+		return iHitCount;
+	}
+
+	int CircleVsCirclesSSE(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pRadius, int iCount, int* pOutHits) {
+		const __m128 vX = _mm_set1_ps(fX);
+		const __m128 vY = _mm_set1_ps(fY);
+		const __m128 vRadius = _mm_set1_ps(fRadius);
+
+		int iHitCount = 0;
+		int i = 0;
+		for (; i + 4 <= iCount; i += 4) {
+			const __m128 vDeltaX = _mm_sub_ps(_mm_loadu_ps(pX + i), vX);
+			const __m128 vDeltaY = _mm_sub_ps(_mm_loadu_ps(pY + i), vY);
+			const __m128 vSumOfRadii = _mm_add_ps(_mm_loadu_ps(pRadius + i), vRadius);
+			const __m128 vDistanceSquared = _mm_add_ps(_mm_mul_ps(vDeltaX, vDeltaX), _mm_mul_ps(vDeltaY, vDeltaY));
+			const int iMask = _mm_movemask_ps(_mm_cmplt_ps(vDistanceSquared, _mm_mul_ps(vSumOfRadii, vSumOfRadii)));
+			iHitCount += WriteHits(iMask, i, pOutHits + iHitCount);
+		}
+		return iHitCount + CircleVsCirclesScalar(fX, fY, fRadius, pX, pY, pRadius, i, iCount, pOutHits + iHitCount);
+	}
+
+	int CircleVsRectanglesSSE(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pHalfWidth, const float* pHalfHeight, int iCount, int* pOutHits) {
+		const __m128 vX = _mm_set1_ps(fX);
+		const __m128 vY = _mm_set1_ps(fY);
+		const __m128 vRadiusSquared = _mm_set1_ps(fRadius * fRadius);
+
+		int iHitCount = 0;
+		int i = 0;
+		for (; i + 4 <= iCount; i += 4) {
+			const __m128 vRectX = _mm_loadu_ps(pX + i);
+			const __m128 vRectY = _mm_loadu_ps(pY + i);
+			const __m128 vHalfWidth = _mm_loadu_ps(pHalfWidth + i);
+			const __m128 vHalfHeight = _mm_loadu_ps(pHalfHeight + i);
+			const __m128 vClosestX = _mm_min_ps(_mm_max_ps(vX, _mm_sub_ps(vRectX, vHalfWidth)), _mm_add_ps(vRectX, vHalfWidth));
+			const __m128 vClosestY = _mm_min_ps(_mm_max_ps(vY, _mm_sub_ps(vRectY, vHalfHeight)), _mm_add_ps(vRectY, vHalfHeight));
+			const __m128 vDeltaX = _mm_sub_ps(vClosestX, vX);
+			const __m128 vDeltaY = _mm_sub_ps(vClosestY, vY);
+			const __m128 vDistanceSquared = _mm_add_ps(_mm_mul_ps(vDeltaX, vDeltaX), _mm_mul_ps(vDeltaY, vDeltaY));
+			const int iMask = _mm_movemask_ps(_mm_cmplt_ps(vDistanceSquared, vRadiusSquared));
+			iHitCount += WriteHits(iMask, i, pOutHits + iHitCount);
+		}
+		return iHitCount + CircleVsRectanglesScalar(fX, fY, fRadius, pX, pY, pHalfWidth, pHalfHeight, i, iCount, pOutHits + iHitCount);
+	}
+
+	COLLISION_KERNELS_TARGET_AVX2
+	int CircleVsCirclesAVX2(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pRadius, int iCount, int* pOutHits) {
+		const __m256 vX = _mm256_set1_ps(fX);
+		const __m256 vY = _mm256_set1_ps(fY);
+		const __m256 vRadius = _mm256_set1_ps(fRadius);
+
+		int iHitCount = 0;
+		int i = 0;
+		for (; i + 8 <= iCount; i += 8) {
+			const __m256 vDeltaX = _mm256_sub_ps(_mm256_loadu_ps(pX + i), vX);
+			const __m256 vDeltaY = _mm256_sub_ps(_mm256_loadu_ps(pY + i), vY);
+			const __m256 vSumOfRadii = _mm256_add_ps(_mm256_loadu_ps(pRadius + i), vRadius);
+			const __m256 vDistanceSquared = _mm256_add_ps(_mm256_mul_ps(vDeltaX, vDeltaX), _mm256_mul_ps(vDeltaY, vDeltaY));
+			const int iMask = _mm256_movemask_ps(_mm256_cmp_ps(vDistanceSquared, _mm256_mul_ps(vSumOfRadii, vSumOfRadii), _CMP_LT_OQ));
+			iHitCount += WriteHits(iMask, i, pOutHits + iHitCount);
+		}
+		return iHitCount + CircleVsCirclesScalar(fX, fY, fRadius, pX, pY, pRadius, i, iCount, pOutHits + iHitCount);
+	}
+
+	COLLISION_KERNELS_TARGET_AVX2
+	int CircleVsRectanglesAVX2(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pHalfWidth, const float* pHalfHeight, int iCount, int* pOutHits) {
+		const __m256 vX = _mm256_set1_ps(fX);
+		const __m256 vY = _mm256_set1_ps(fY);
+		const __m256 vRadiusSquared = _mm256_set1_ps(fRadius * fRadius);
+
+		int iHitCount = 0;
+		int i = 0;
+		for (; i + 8 <= iCount; i += 8) {
+			const __m256 vRectX = _mm256_loadu_ps(pX + i);
+			const __m256 vRectY = _mm256_loadu_ps(pY + i);
+			const __m256 vHalfWidth = _mm256_loadu_ps(pHalfWidth + i);
+			const __m256 vHalfHeight = _mm256_loadu_ps(pHalfHeight + i);
+			const __m256 vClosestX = _mm256_min_ps(_mm256_max_ps(vX, _mm256_sub_ps(vRectX, vHalfWidth)), _mm256_add_ps(vRectX, vHalfWidth));
+			const __m256 vClosestY = _mm256_min_ps(_mm256_max_ps(vY, _mm256_sub_ps(vRectY, vHalfHeight)), _mm256_add_ps(vRectY, vHalfHeight));
+			const __m256 vDeltaX = _mm256_sub_ps(vClosestX, vX);
+			const __m256 vDeltaY = _mm256_sub_ps(vClosestY, vY);
+			const __m256 vDistanceSquared = _mm256_add_ps(_mm256_mul_ps(vDeltaX, vDeltaX), _mm256_mul_ps(vDeltaY, vDeltaY));
+			const int iMask = _mm256_movemask_ps(_mm256_cmp_ps(vDistanceSquared, vRadiusSquared, _CMP_LT_OQ));
+			iHitCount += WriteHits(iMask, i, pOutHits + iHitCount);
+		}
+		return iHitCount + CircleVsRectanglesScalar(fX, fY, fRadius, pX, pY, pHalfWidth, pHalfHeight, i, iCount, pOutHits + iHitCount);
+	}
+#endif
+
+	InstructionSet DetectInstructionSet() {
+#ifdef COLLISION_KERNELS_X86
+#if defined(_MSC_VER)
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 0);
+		const int iHighestLeaf = cpuInfo[0];
+
+		__cpuid(cpuInfo, 1);
+		const bool bHasSSE2 = (cpuInfo[3] & (1 << 26)) != 0;
+		const bool bHasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+		const bool bHasOSXSAVE = (cpuInfo[2] & (1 << 27)) != 0;
+
+		bool bHasAVX2 = false;
+		// The OS also has to save the upper halves of the ymm registers on context switches
+		if (bHasAVX && bHasOSXSAVE && iHighestLeaf >= 7 && (_xgetbv(0) & 0x6) == 0x6) {
+			__cpuidex(cpuInfo, 7, 0);
+			bHasAVX2 = (cpuInfo[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		const bool bHasSSE2 = __builtin_cpu_supports("sse2");
+		const bool bHasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+		if (bHasAVX2) {
+			return InstructionSet::AVX2;
+		}
+		if (bHasSSE2) {
+			return InstructionSet::SSE;
+		}
+#endif
+		return InstructionSet::Scalar;
+	}
+
+	InstructionSet GetSupportedInstructionSet() {
+		static const InstructionSet eSupported = DetectInstructionSet();
+		return eSupported;
+	}
+
+	InstructionSet s_eActiveInstructionSet = GetSupportedInstructionSet();
+}
+
+namespace CollisionKernels {
+	InstructionSet GetInstructionSet() {
+		return s_eActiveInstructionSet;
+	}
+
+	const char* GetInstructionSetName(InstructionSet eInstructionSet) {
+		switch (eInstructionSet) {
+		case InstructionSet::SSE:
+			return "SSE";
+		case InstructionSet::AVX2:
+			return "AVX2";
+		default:
+			return "Scalar";
+		}
+	}
+
+	void SetInstructionSet(InstructionSet eInstructionSet) {
+		s_eActiveInstructionSet = std::min(eInstructionSet, GetSupportedInstructionSet());
+	}
+
+	int CircleVsCircles(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pRadius, int iCount, int* pOutHits) {
+		switch (s_eActiveInstructionSet) {
+#ifdef COLLISION_KERNELS_X86
+		case InstructionSet::AVX2:
+			return CircleVsCirclesAVX2(fX, fY, fRadius, pX, pY, pRadius, iCount, pOutHits);
+		case InstructionSet::SSE:
+			return CircleVsCirclesSSE(fX, fY, fRadius, pX, pY, pRadius, iCount, pOutHits);
+#endif
+		default:
+			return CircleVsCirclesScalar(fX, fY, fRadius, pX, pY, pRadius, 0, iCount, pOutHits);
+		}
+	}
+
+	int CircleVsRectangles(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pHalfWidth, const float* pHalfHeight, int iCount, int* pOutHits) {
+		switch (s_eActiveInstructionSet) {
+#ifdef COLLISION_KERNELS_X86
+		case InstructionSet::AVX2:
+			return CircleVsRectanglesAVX2(fX, fY, fRadius, pX, pY, pHalfWidth, pHalfHeight, iCount, pOutHits);
+		case InstructionSet::SSE:
+			return CircleVsRectanglesSSE(fX, fY, fRadius, pX, pY, pHalfWidth, pHalfHeight, iCount, pOutHits);
+#endif
+		default:
+			return CircleVsRectanglesScalar(fX, fY, fRadius, pX, pY, pHalfWidth, pHalfHeight, 0, iCount, pOutHits);
+		}
+	}
+}
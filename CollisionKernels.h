@@ -0,0 +1,30 @@
+#pragma once
+
+// Batched narrowphase tests of one shape against a block of candidates stored as
+// separate x/y/size arrays. Every kernel compares squared distances, so no sqrt is
+// taken here; the caller only pays for one on the pairs that actually touch.
+// The widest instruction set the CPU supports is picked during static initialization,
+// SetInstructionSet() can narrow it afterwards.
+namespace CollisionKernels {
+	enum class InstructionSet {
+		Scalar,
+		SSE, // 4 candidates per iteration
+		AVX2 // 8 candidates per iteration
+	};
+
+	InstructionSet GetInstructionSet();
+	const char* GetInstructionSetName(InstructionSet eInstructionSet);
+
+	// Restrict the kernels to a narrower path, e.g. to compare results against Scalar.
+	// Requests wider than what the CPU supports are ignored.
+	void SetInstructionSet(InstructionSet eInstructionSet);
+
+	// Writes the index of every circle overlapping the circle (fX, fY, fRadius) into pOutHits
+	// and returns how many were written. pOutHits must have room for iCount entries.
+	int CircleVsCircles(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pRadius, int iCount, int* pOutHits);
+
+	// Same as CircleVsCircles for axis aligned rectangles given by centre and half size
+	int CircleVsRectangles(float fX, float fY, float fRadius,
+		const float* pX, const float* pY, const float* pHalfWidth, const float* pHalfHeight, int iCount, int* pOutHits);
+}
@@ -2,8 +2,17 @@
 
 DamageTextManager DamageTextManager::m_Instance;
 
-DamageTextManager::DamageTextManager() {
+DamageTextManager::DamageTextManager()
+	: m_DamageTextList(m_iMaxDamageTexts)
+	, m_iNextDamageText(0)
+{
 	m_Font.loadFromFile("Fonts/Kreon-Medium.ttf");
+
+	for (DamageText& damageText : m_DamageTextList) {
+		damageText.m_Text.setFont(m_Font);
+		damageText.m_Text.setCharacterSize(36);
+		damageText.m_Text.setOutlineThickness(2.0f);
+	}
 }
 
 DamageTextManager::~DamageTextManager() {
@@ -11,12 +20,10 @@ DamageTextManager::~DamageTextManager() {
 }
 
 void DamageTextManager::Update(sf::Time& rDeltaTime) {
-	const int iCount = m_DamageTextList.size();
-	for (int i = 0; i < iCount; i++) {
-		DamageText damageText = m_DamageTextList.front();
-		m_DamageTextList.pop_front();
-		damageText.m_fRemainingLifeSeconds -= rDeltaTime.asSeconds();
+	for (DamageText& damageText : m_DamageTextList) {
+		if (damageText.m_fRemainingLifeSeconds <= 0.0f) continue;
 
+		damageText.m_fRemainingLifeSeconds -= rDeltaTime.asSeconds();
 		if (damageText.m_fRemainingLifeSeconds > 0.0f) {
 			//Fade out the damage text over time
 			float fPercentageThroughLife = damageText.m_fRemainingLifeSeconds / m_fDamageTextLifeInSeconds;
@@ -29,31 +36,33 @@ void DamageTextManager::Update(sf::Time& rDeltaTime) {
 
 			damageText.m_Text.setFillColor(color);
 			damageText.m_Text.setOutlineColor(OutlineColor);
-
-			m_DamageTextList.push_back(damageText);
 		}
 	}
 }
 
-void DamageTextManager::Draw(sf::RenderTarget& rRenderTarget) const {
+void DamageTextManager::Draw(sf::RenderTarget& rRenderTarget, const sf::FloatRect& rVisibleArea) const {
 	for (const DamageText& damageText : m_DamageTextList) {
-		rRenderTarget.draw(damageText.m_Text);
+		if (damageText.m_fRemainingLifeSeconds > 0.0f && rVisibleArea.intersects(damageText.m_Text.getGlobalBounds())) {
+			rRenderTarget.draw(damageText.m_Text);
+		}
 	}
 }
 
 void DamageTextManager::AddDamageText(int damage, const sf::Vector2f& pos) {
-	sf::Text text;
-	text.setFont(m_Font);
-	text.setString(std::to_string(damage));
-	text.setCharacterSize(36);
+	AddText(std::to_string(damage), pos, sf::Color::White);
+}
+
+void DamageTextManager::AddText(const sf::String& string, const sf::Vector2f& pos, const sf::Color& color) {
+	// Reuse the oldest text, its string and vertex buffers keep their capacity
+	DamageText& damageText = m_DamageTextList[m_iNextDamageText];
+	m_iNextDamageText = (m_iNextDamageText + 1) % m_iMaxDamageTexts;
+
+	sf::Text& text = damageText.m_Text;
+	text.setString(string);
+	text.setFillColor(color);
 	text.setOutlineColor(sf::Color::Black);
-	text.setOutlineThickness(2.0f);
 	text.setPosition(pos);
 	text.setOrigin(text.getLocalBounds().width / 2.0f, text.getLocalBounds().height / 2.0f);
 
-	DamageText damageText;
-	damageText.m_Text = text;
 	damageText.m_fRemainingLifeSeconds = m_fDamageTextLifeInSeconds;
-
-	m_DamageTextList.push_back(damageText);
-}
\ No newline at end of file
+}
@@ -20,9 +20,12 @@ private:
 	~DamageTextManager();
 public:
 	void Update(sf::Time& rDeltaTime);
-	void Draw(sf::RenderTarget& rRenderTarget) const;
+	// Only the texts overlapping rVisibleArea are drawn
+	void Draw(sf::RenderTarget& rRenderTarget, const sf::FloatRect& rVisibleArea) const;
 
 	void AddDamageText(int damage, const sf::Vector2f& pos);
+	// Any short message that pops up and fades like the damage numbers
+	void AddText(const sf::String& string, const sf::Vector2f& pos, const sf::Color& color);
 
 	static const DamageTextManager& getInstanceConst() {
 		return m_Instance;
@@ -34,13 +37,17 @@ public:
 private:
 	static DamageTextManager m_Instance;
 	static float constexpr m_fDamageTextLifeInSeconds = 1.0f;
+	static int constexpr m_iMaxDamageTexts = 64;
 
 	struct DamageText {
 		sf::Text m_Text;
-		float m_fRemainingLifeSeconds;
+		float m_fRemainingLifeSeconds = 0.0f; // Free slot when <= 0
 	};
 	sf::Font m_Font;
-	std::deque<DamageText> m_DamageTextList;
+	// Fixed pool used as a ring. Every text lives equally long, so the next slot is always
+	// the oldest one and reusing it never allocates.
+	std::vector<DamageText> m_DamageTextList;
+	int m_iNextDamageText;
 };
 
 #endif
\ No newline at end of file
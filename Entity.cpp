@@ -2,25 +2,23 @@
 #include "MathHelpers.h"
 #include "DamageTextManager.h"
 
-Entity::Entity(PhysicsData::Type ePhysicsType)
-	: m_fAttackTimer(1.0f)
+Entity::Entity(ArchetypeRegistry::Id archetypeId)
+	: m_ArchetypeId(archetypeId)
+	, m_fRotation(0.0f)
+	, m_BodyId(PhysicsWorld::InvalidBody)
 	, m_bDeletionRequested(false)
-	, m_fAxeTimer(3.0f)
+	, m_iPathIndex(0)
+	, m_eTargetingPolicy(TargetingPolicy::Closest)
 {
-	m_PhysicsData.m_eType = ePhysicsType;
+	m_iHealth = GetArchetype().m_Stats.m_iHealth;
 }
 
-void Entity::OnCollision(Entity& pOtherEntity) {
-	if (pOtherEntity.GetPhysicsData().IsInAnyLayer(PhysicsData::Layer::Enemy)) {
+void Entity::OnCollision(const Entity& rOtherEntity, const sf::Vector2f& vNormal, const PhysicsWorld& rPhysicsWorld, CollisionEventQueue& rEvents) const {
+	if (rPhysicsWorld.IsInAnyLayer(rOtherEntity.GetBodyId(), PhysicsWorld::Layer::Enemy)) {
 		//If we are a projectile
-		if (GetPhysicsData().IsInAnyLayer(PhysicsData::Layer::Projectile)) {
-			sf::Vector2f direction = pOtherEntity.GetPosition() - GetPosition();
-			direction = MathHelpers::normalize(direction);
-			pOtherEntity.GetPhysicsDataNonConst().AddImpulse(direction * 80.0f);
-
-			//Projectile hit the enemy
-			pOtherEntity.DealDamage(1);
-			m_bDeletionRequested = true;
+		if (rPhysicsWorld.IsInAnyLayer(GetBodyId(), PhysicsWorld::Layer::Projectile)) {
+			//Projectile hit the enemy, the game applies the damage after physics
+			rEvents.Push({ CollisionEventQueue::Kind::ProjectileHitEnemy, GetBodyId(), rOtherEntity.GetBodyId(), vNormal });
 		}
 	}
 }
@@ -1,195 +1,101 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include <vector>
+#include "PhysicsWorld.h"
+#include "CollisionEventQueue.h"
+#include "SlotMap.h"
+#include "ArchetypeRegistry.h"
+#include "RoutePolyline.h"
 using namespace std;
 #ifndef ENTITY_H	
 #define ENTITY_H
 
-class Entity : public sf::Drawable
+// How a tower picks one of the enemies in its range
+enum class TargetingPolicy : unsigned char {
+	Closest,
+	First, // Furthest along its path
+	Last,
+	Strongest, // Most health left
+	Weakest,
+	Count
+};
+
+// Drawn through the sprite batch from the sprite of its archetype, entities only keep their own state
+class Entity
 {
 public:
-	struct PhysicsData {
-		PhysicsData() {
-			m_vImpulse = sf::Vector2f(0.0f, 0.0f);
-		}
-
-		enum Layer {
-			Enemy = 1, //0b0001
-			Tower = 2, //0b0010
-			Projectile = 4 // 0b0100
-		};
-		enum class Shape {
-			Circle,
-			Rectangle
-		};
-
-		enum class Type {
-			Static,
-			Dynamic
-		};
-		Shape m_eShape;
-		Type m_eType;
-
-		void setLayers(int layers) {
-			m_iMyLayer = layers;
-		}
-
-		void setLayersToIgnore(int layers) {
-			m_iLayersToIgnore = layers;
-		}
-
-		int getLayersToIgnore() const {
-			return m_iLayersToIgnore;
-		}
-
-		bool IsInAnyLayer(int layer) const {
-			return (m_iMyLayer & layer) != 0;
-		}
-
-		void ClearCollisions() {
-			m_EntitiesThatCollidedWithAlready.clear();
-		}
-
-		bool HasCollidedThisUpdate(Entity* pOtherEntity) const {
-			for (Entity* pEntity : m_EntitiesThatCollidedWithAlready) {
-				if (pEntity == pOtherEntity) {
-					return true;
-				}
-			}
-			return false;
-		}
-
-		void AddEntityCollision(Entity* pOtherEntity) {
-			m_EntitiesThatCollidedWithAlready.push_back(pOtherEntity);
-		}
-
-		void ClearImpulse() {
-			m_vImpulse = sf::Vector2f(0.0f, 0.0f);
-		}
-
-		void AddImpulse(const sf::Vector2f& impulse) {
-			m_vImpulse += impulse;
-		}
-
-		int m_iMyLayer;
-		int m_iLayersToIgnore;
-
-		float m_fRadius; // For Circle shape
-		float m_fWidth; // For Rectangle shape
-		float m_fHeight; // For Rectangle shape
-
-		sf::Vector2f m_vVelocity;
-		sf::Vector2f m_vImpulse;
-
-		vector<Entity*> m_IgnoredEntities; // Entities to ignore for collision
-		vector<Entity*> m_EntitiesToIgnore;
-		vector<Entity*> m_EntitiesThatCollidedWithAlready;
-	};
-
-	Entity(PhysicsData::Type ePhysicsType);
+	// Health starts from the stats of the archetype
+	explicit Entity(ArchetypeRegistry::Id archetypeId);
 	~Entity() {};
 
-	void setCirclePhysics(float radius) {
-		m_PhysicsData.m_eShape = PhysicsData::Shape::Circle;
-		m_PhysicsData.m_fRadius = radius;
-	}
-
-	void setRectanglePhysics(float width, float height) {
-		m_PhysicsData.m_eShape = PhysicsData::Shape::Rectangle;
-		m_PhysicsData.m_fWidth = width;
-		m_PhysicsData.m_fHeight = height;
+	ArchetypeRegistry::Id GetArchetypeId() const {
+		return m_ArchetypeId;
 	}
 
-	void addIgnoredEntity(Entity* entity) {
-		m_PhysicsData.m_IgnoredEntities.push_back(entity);
-	}
-
-	bool shouldIgnoreEntityForPhysics(Entity* entity) const {
-		for (const auto& ignoredEntity : m_PhysicsData.m_IgnoredEntities) {
-			if (ignoredEntity == entity) {
-				return true;
-			}
-		}
-
-		if (entity->GetPhysicsData().IsInAnyLayer(m_PhysicsData.getLayersToIgnore())) {
-			return true;
-		}
-		return false;
+	const ArchetypeRegistry::Archetype& GetArchetype() const {
+		return ArchetypeRegistry::getInstanceConst().Get(m_ArchetypeId);
 	}
 
-	void SetVelocity(const sf::Vector2f& velocity) {
-		m_PhysicsData.m_vVelocity = velocity;
+	void SetBodyId(PhysicsWorld::BodyId bodyId) {
+		m_BodyId = bodyId;
 	}
 
-	void SetTexture(const sf::Texture& texture) {
-		m_Sprite.setTexture(texture);
+	PhysicsWorld::BodyId GetBodyId() const {
+		return m_BodyId;
 	}
 
-	void SetScale(const sf::Vector2f& scale) {
-		m_Sprite.setScale(scale);
-	}
-
-	void SetOrigin(const sf::Vector2f& origin) {
-		m_Sprite.setOrigin(origin);
+	bool HasBody() const {
+		return m_BodyId != PhysicsWorld::InvalidBody;
 	}
 
 	void SetPosition(const sf::Vector2f& position) {
-		m_Sprite.setPosition(position);
-	}
-
-	void SetColor(const sf::Color& color) {
-		m_Sprite.setColor(color);
-	}
-
-	void SetSprite(const sf::Sprite& sprite) {
-		m_Sprite = sprite;
+		m_vPosition = position;
 	}
 
-	const sf::Sprite& GetSprite() const {
-		return m_Sprite;
+	void SetRotation(float fRotation) {
+		m_fRotation = fRotation;
 	}
 
-	sf::Sprite& GetSpriteNonConst() {
-		return m_Sprite;
+	float GetRotation() const {
+		return m_fRotation;
 	}
 
 	void move(const sf::Vector2f& offset) {
-		m_Sprite.move(offset);
-	}
-
-	void draw(sf::RenderTarget& target, sf::RenderStates states) const override {
-		target.draw(m_Sprite, states);
+		m_vPosition += offset;
 	}
 
 	sf::Vector2f GetPosition() const {
-		return m_Sprite.getPosition();
+		return m_vPosition;
 	}
 
-	sf::Vector2i GetClosestGridCoordinates() const {
-		return sf::Vector2i(GetPosition().x / 160, GetPosition().y / 160);
+	void SetPathIndex(int index) {
+		m_iPathIndex = index;
 	}
 
-	PhysicsData::Type GetPhysicsShapeType() const {
-		return m_PhysicsData.m_eType;
+	int GetPathIndex() const {
+		return m_iPathIndex;
 	}
 
-	const PhysicsData& GetPhysicsData() const {
-		return m_PhysicsData;
+	// Where the enemy is on the route of its path index, moved by the enemy steering every update
+	RoutePolyline::Cursor& GetPathCursor() {
+		return m_PathCursor;
 	}
 
-	PhysicsData& GetPhysicsDataNonConst() {
-		return m_PhysicsData;
+	// Distance walked along the path
+	float GetPathProgress() const {
+		return m_PathCursor.m_fDistance;
 	}
 
-	void SetPathIndex(int index) {
-		m_iPathIndex = index;
+	void SetTargetingPolicy(TargetingPolicy eTargetingPolicy) {
+		m_eTargetingPolicy = eTargetingPolicy;
 	}
 
-	int GetPathIndex() const {
-		return m_iPathIndex;
+	TargetingPolicy GetTargetingPolicy() const {
+		return m_eTargetingPolicy;
 	}
 
-	void OnCollision(Entity& pOtherEntity);
+	// Only records what should happen in rEvents, so it can run on any thread
+	void OnCollision(const Entity& rOtherEntity, const sf::Vector2f& vNormal, const PhysicsWorld& rPhysicsWorld, CollisionEventQueue& rEvents) const;
 
 	void SetHealth(int health) {
 		m_iHealth = health;
@@ -210,15 +116,19 @@ public:
 	}
 
 private:
-	sf::Sprite m_Sprite;
-	PhysicsData m_PhysicsData;
+	ArchetypeRegistry::Id m_ArchetypeId;
+	sf::Vector2f m_vPosition;
+	float m_fRotation;
+	PhysicsWorld::BodyId m_BodyId;
 	bool m_bDeletionRequested;
 
 	int m_iPathIndex;
+	RoutePolyline::Cursor m_PathCursor;
 	int m_iHealth;
-public:
-	float m_fAxeTimer;
-	float m_fAttackTimer;
+	TargetingPolicy m_eTargetingPolicy;
 };
 
+typedef SlotHandle EntityHandle;
+typedef SlotMap<Entity> EntityList;
+
 #endif; 
\ No newline at end of file
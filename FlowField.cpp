@@ -0,0 +1,203 @@
+#include "FlowField.h"
+#include "PathGraph.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+	// Same order as the PathGraph directions: north, east, south, west
+	const sf::Vector2i CellOffsets[PathGraph::DirectionCount] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+
+	int GetOppositeDirection(int iDirection) {
+		return (iDirection + 2) % PathGraph::DirectionCount;
+	}
+}
+
+FlowField::FlowField()
+	: m_iWidth(0)
+	, m_iHeight(0)
+	, m_iMargin(0)
+{
+}
+
+void FlowField::Clear() {
+	m_iWidth = 0;
+	m_iHeight = 0;
+	m_NextCell.clear();
+	m_Distance.clear();
+}
+
+void FlowField::Build(const PathGraph& rGraph, int iGoalNode, int iMargin) {
+	Clear();
+	const int iNodeCount = rGraph.GetNodeCount();
+	if (iNodeCount == 0 || iGoalNode < 0) {
+		return;
+	}
+
+	sf::Vector2i vMin = rGraph.GetCoords(0);
+	sf::Vector2i vMax = vMin;
+	for (int iNode = 1; iNode < iNodeCount; iNode++) {
+		const sf::Vector2i& vCoords = rGraph.GetCoords(iNode);
+		vMin.x = std::min(vMin.x, vCoords.x);
+		vMin.y = std::min(vMin.y, vCoords.y);
+		vMax.x = std::max(vMax.x, vCoords.x);
+		vMax.y = std::max(vMax.y, vCoords.y);
+	}
+	m_iMargin = iMargin;
+	m_vOrigin = vMin - sf::Vector2i(iMargin, iMargin);
+	m_iWidth = vMax.x - vMin.x + 1 + iMargin * 2;
+	m_iHeight = vMax.y - vMin.y + 1 + iMargin * 2;
+	m_vGoal = rGraph.GetCoords(iGoalNode);
+	m_NextCell.assign(m_iWidth * m_iHeight, -1);
+	m_Distance.assign(m_iWidth * m_iHeight, -1);
+
+	std::vector<QueueEntry> queue;
+	std::vector<int> changedCells;
+	m_Distance[GetCellIndex(m_vGoal)] = 0;
+	queue.push_back({ 0, GetCellIndex(m_vGoal) });
+	Propagate(rGraph, queue, changedCells);
+
+	for (int iCell = 0; iCell < (int)m_NextCell.size(); iCell++) {
+		if (rGraph.FindNode(GetCell(iCell)) < 0) {
+			UpdateOffGraphCell(rGraph, iCell);
+		}
+	}
+}
+
+bool FlowField::Repair(const PathGraph& rGraph, const sf::Vector2i& vCell) {
+	const sf::Vector2i vMargin(m_iMargin, m_iMargin);
+	if (IsEmpty() || !Contains(vCell - vMargin) || !Contains(vCell + vMargin)) {
+		return false;
+	}
+
+	// The edges changed out of vCell and its neighbours. Every graph cell whose way to the goal runs
+	// through one of them has to find a new one, the rest of the field keeps its distances.
+	std::vector<int> invalidCells;
+	std::vector<char> isInvalid(m_NextCell.size(), 0);
+	auto Invalidate = [&](const sf::Vector2i& vInvalidCell) {
+		if (!Contains(vInvalidCell) || vInvalidCell == m_vGoal) return;
+		const int iCell = GetCellIndex(vInvalidCell);
+		if (isInvalid[iCell]) return;
+		isInvalid[iCell] = 1;
+		invalidCells.push_back(iCell);
+	};
+	Invalidate(vCell);
+	for (const sf::Vector2i& vOffset : CellOffsets) {
+		Invalidate(vCell + vOffset);
+	}
+	for (size_t uNext = 0; uNext < invalidCells.size(); uNext++) {
+		const sf::Vector2i vInvalidCell = GetCell(invalidCells[uNext]);
+		for (const sf::Vector2i& vOffset : CellOffsets) {
+			const sf::Vector2i vChild = vInvalidCell + vOffset;
+			if (Contains(vChild) && m_NextCell[GetCellIndex(vChild)] == invalidCells[uNext] && rGraph.FindNode(vChild) >= 0) {
+				Invalidate(vChild);
+			}
+		}
+	}
+	for (int iCell : invalidCells) {
+		m_NextCell[iCell] = -1;
+		m_Distance[iCell] = -1;
+	}
+
+	// Start every invalidated graph cell from its best neighbour that kept its distance
+	std::vector<QueueEntry> queue;
+	for (int iCell : invalidCells) {
+		const int iNode = rGraph.FindNode(GetCell(iCell));
+		if (iNode < 0) continue;
+
+		for (int iDirection = 0; iDirection < PathGraph::DirectionCount; iDirection++) {
+			const int iNeighbor = rGraph.GetNeighbor(iNode, iDirection);
+			if (iNeighbor < 0) continue;
+
+			const int iNeighborCell = GetCellIndex(rGraph.GetCoords(iNeighbor));
+			if (m_Distance[iNeighborCell] < 0) continue;
+			if (m_Distance[iCell] < 0 || m_Distance[iNeighborCell] + 1 < m_Distance[iCell]) {
+				m_Distance[iCell] = m_Distance[iNeighborCell] + 1;
+				m_NextCell[iCell] = iNeighborCell;
+			}
+		}
+		if (m_Distance[iCell] >= 0) {
+			queue.push_back({ m_Distance[iCell], iCell });
+		}
+	}
+	std::make_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+
+	std::vector<int> changedCells(invalidCells);
+	Propagate(rGraph, queue, changedCells);
+
+	// Off-graph cells only look at their neighbours, so only those next to a change need updating
+	for (int iChangedCell : changedCells) {
+		const sf::Vector2i vChangedCell = GetCell(iChangedCell);
+		if (rGraph.FindNode(vChangedCell) < 0) {
+			UpdateOffGraphCell(rGraph, iChangedCell);
+		}
+		for (const sf::Vector2i& vOffset : CellOffsets) {
+			const sf::Vector2i vNeighbor = vChangedCell + vOffset;
+			if (Contains(vNeighbor) && rGraph.FindNode(vNeighbor) < 0) {
+				UpdateOffGraphCell(rGraph, GetCellIndex(vNeighbor));
+			}
+		}
+	}
+	return true;
+}
+
+void FlowField::Propagate(const PathGraph& rGraph, std::vector<QueueEntry>& rQueue, std::vector<int>& rChangedCells) {
+	// Every step costs the same, a heap keeps the order right when the queue starts at different distances
+	while (!rQueue.empty()) {
+		std::pop_heap(rQueue.begin(), rQueue.end(), std::greater<QueueEntry>());
+		const QueueEntry entry = rQueue.back();
+		rQueue.pop_back();
+		const int iCell = entry.second;
+		if (entry.first != m_Distance[iCell]) continue; // Found a shorter way since
+
+		const sf::Vector2i vCell = GetCell(iCell);
+		const int iNode = rGraph.FindNode(vCell);
+		for (int iDirection = 0; iDirection < PathGraph::DirectionCount; iDirection++) {
+			// Edges can be one way, the neighbour has to lead into this cell
+			const sf::Vector2i vFrom = vCell + CellOffsets[iDirection];
+			const int iFromNode = rGraph.FindNode(vFrom);
+			if (iFromNode < 0 || rGraph.GetNeighbor(iFromNode, GetOppositeDirection(iDirection)) != iNode) continue;
+
+			const int iFromCell = GetCellIndex(vFrom);
+			if (m_Distance[iFromCell] >= 0 && m_Distance[iFromCell] <= entry.first + 1) continue;
+
+			m_Distance[iFromCell] = entry.first + 1;
+			m_NextCell[iFromCell] = iCell;
+			rChangedCells.push_back(iFromCell);
+			rQueue.push_back({ entry.first + 1, iFromCell });
+			std::push_heap(rQueue.begin(), rQueue.end(), std::greater<QueueEntry>());
+		}
+	}
+}
+
+void FlowField::UpdateOffGraphCell(const PathGraph& rGraph, int iCell) {
+	m_NextCell[iCell] = -1;
+	m_Distance[iCell] = -1;
+	const sf::Vector2i vCell = GetCell(iCell);
+	for (const sf::Vector2i& vOffset : CellOffsets) {
+		const sf::Vector2i vNeighbor = vCell + vOffset;
+		if (!Contains(vNeighbor) || rGraph.FindNode(vNeighbor) < 0) continue;
+
+		const int iNeighborCell = GetCellIndex(vNeighbor);
+		if (m_Distance[iNeighborCell] < 0) continue;
+		if (m_Distance[iCell] < 0 || m_Distance[iNeighborCell] + 1 < m_Distance[iCell]) {
+			m_Distance[iCell] = m_Distance[iNeighborCell] + 1;
+			m_NextCell[iCell] = iNeighborCell;
+		}
+	}
+}
+
+sf::Vector2i FlowField::GetNextCell(const sf::Vector2i& vCell) const {
+	if (IsEmpty()) {
+		return vCell;
+	}
+	if (!Contains(vCell)) {
+		return sf::Vector2i(std::clamp(vCell.x, m_vOrigin.x, m_vOrigin.x + m_iWidth - 1), std::clamp(vCell.y, m_vOrigin.y, m_vOrigin.y + m_iHeight - 1));
+	}
+
+	const int iNextCell = m_NextCell[GetCellIndex(vCell)];
+	return iNextCell >= 0 ? GetCell(iNextCell) : vCell;
+}
+
+int FlowField::GetDistance(const sf::Vector2i& vCell) const {
+	return Contains(vCell) ? m_Distance[GetCellIndex(vCell)] : -1;
+}
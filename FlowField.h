@@ -0,0 +1,65 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+class PathGraph;
+
+// Next cell to walk to from every cell of a grid region, towards one goal node of a PathGraph.
+// Built once whenever the map changes, after that any number of walkers look up their
+// direction in O(1). Cells of the graph follow its edges, every other cell leads into the
+// neighbouring graph cell closest to the goal.
+class FlowField
+{
+public:
+	FlowField();
+
+	// Covers the bounding box of the graph nodes plus iMargin cells on every side
+	void Build(const PathGraph& rGraph, int iGoalNode, int iMargin);
+	void Clear();
+
+	// Updates the field after a node at vCell was inserted into or removed from the graph. Only the
+	// cells whose way to the goal led through the changed edges are searched again, plus any cell the
+	// change gives a shorter way. False if the field does not cover the margin around vCell, Build() it again then.
+	bool Repair(const PathGraph& rGraph, const sf::Vector2i& vCell);
+
+	bool IsEmpty() const {
+		return m_NextCell.empty();
+	}
+
+	// vCell itself at the goal or where the goal cannot be reached. Cells outside the field
+	// lead to the closest cell on its border.
+	sf::Vector2i GetNextCell(const sf::Vector2i& vCell) const;
+
+	// Steps to the goal, -1 where it cannot be reached
+	int GetDistance(const sf::Vector2i& vCell) const;
+
+private:
+	typedef std::pair<int, int> QueueEntry; // Distance, cell index
+
+	// Settles the queued cells in order of distance and passes shorter distances on to the graph
+	// nodes leading into them. Every cell whose distance changed is added to rChangedCells.
+	void Propagate(const PathGraph& rGraph, std::vector<QueueEntry>& rQueue, std::vector<int>& rChangedCells);
+
+	// Off the graph a cell steps into its neighbouring graph cell closest to the goal
+	void UpdateOffGraphCell(const PathGraph& rGraph, int iCell);
+
+	bool Contains(const sf::Vector2i& vCell) const {
+		return vCell.x >= m_vOrigin.x && vCell.y >= m_vOrigin.y && vCell.x < m_vOrigin.x + m_iWidth && vCell.y < m_vOrigin.y + m_iHeight;
+	}
+
+	int GetCellIndex(const sf::Vector2i& vCell) const {
+		return (vCell.y - m_vOrigin.y) * m_iWidth + vCell.x - m_vOrigin.x;
+	}
+
+	sf::Vector2i GetCell(int iCellIndex) const {
+		return sf::Vector2i(m_vOrigin.x + iCellIndex % m_iWidth, m_vOrigin.y + iCellIndex / m_iWidth);
+	}
+
+	sf::Vector2i m_vOrigin;
+	int m_iWidth;
+	int m_iHeight;
+	int m_iMargin;
+	sf::Vector2i m_vGoal;
+	std::vector<int> m_NextCell; // Cell index, -1 at the goal and where it cannot be reached
+	std::vector<int> m_Distance;
+};
@@ -0,0 +1,67 @@
+#include "HudField.h"
+#include <charconv>
+#include <cstring>
+
+HudField::HudField()
+	: m_iDecimals(0)
+	, m_iShownLength(-1)
+{
+}
+
+void HudField::Setup(const sf::Font& rFont, unsigned int uCharacterSize, const sf::String& label, const sf::Vector2f& vPosition, int iDecimals, sf::Time refreshInterval) {
+	m_Label.setFont(rFont);
+	m_Label.setCharacterSize(uCharacterSize);
+	m_Label.setString(label);
+	m_Label.setPosition(vPosition);
+
+	// The value starts where the label ends, trailing spaces included
+	m_Value.setFont(rFont);
+	m_Value.setCharacterSize(uCharacterSize);
+	m_Value.setPosition(m_Label.findCharacterPos(label.getSize()));
+
+	m_iDecimals = iDecimals;
+	m_RefreshInterval = refreshInterval;
+	m_iShownLength = -1;
+}
+
+bool HudField::SetValue(int iValue) {
+	if (!IsRefreshDue()) return false;
+
+	char buffer[BufferSize];
+	const std::to_chars_result result = std::to_chars(buffer, buffer + BufferSize, iValue);
+	return SetText(buffer, result.ptr);
+}
+
+bool HudField::SetValue(float fValue) {
+	if (!IsRefreshDue()) return false;
+
+	char buffer[BufferSize];
+	std::to_chars_result result = std::to_chars(buffer, buffer + BufferSize, fValue, std::chars_format::fixed, m_iDecimals);
+	if (result.ec != std::errc()) {
+		// Too many digits for the buffer, nothing a HUD should show
+		result = std::to_chars(buffer, buffer + BufferSize, fValue, std::chars_format::scientific, m_iDecimals);
+	}
+	return SetText(buffer, result.ptr);
+}
+
+bool HudField::IsRefreshDue() const {
+	return m_iShownLength < 0 || m_SinceRefresh.getElapsedTime() >= m_RefreshInterval;
+}
+
+bool HudField::SetText(const char* pBegin, const char* pEnd) {
+	m_SinceRefresh.restart();
+	const int iLength = (int)(pEnd - pBegin);
+	if (iLength == m_iShownLength && std::memcmp(pBegin, m_Shown, iLength) == 0) {
+		return false;
+	}
+
+	std::memcpy(m_Shown, pBegin, iLength);
+	m_iShownLength = iLength;
+	m_Value.setString(sf::String::fromUtf8(pBegin, pEnd));
+	return true;
+}
+
+void HudField::Draw(sf::RenderTarget& rTarget) const {
+	rTarget.draw(m_Label);
+	rTarget.draw(m_Value);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+
+// One value of the HUD, drawn as a label followed by the value. The label is laid out once and
+// the value only when its formatted text changes, so on frames where nothing changed drawing
+// it costs two draw calls and no glyph layout. Values that change continuously can be given a
+// refresh interval, in between they keep showing the last one.
+class HudField
+{
+public:
+	HudField();
+
+	// iDecimals only applies to float values
+	void Setup(const sf::Font& rFont, unsigned int uCharacterSize, const sf::String& label, const sf::Vector2f& vPosition,
+		int iDecimals = 0, sf::Time refreshInterval = sf::Time::Zero);
+
+	// Both return true when the text was laid out again
+	bool SetValue(int iValue);
+	bool SetValue(float fValue);
+
+	void Draw(sf::RenderTarget& rTarget) const;
+
+private:
+	// Sets the value text from the formatted characters if they differ from the shown ones
+	bool SetText(const char* pBegin, const char* pEnd);
+	bool IsRefreshDue() const;
+
+	static constexpr int BufferSize = 32;
+
+	sf::Text m_Label;
+	sf::Text m_Value;
+	int m_iDecimals;
+	sf::Time m_RefreshInterval;
+	sf::Clock m_SinceRefresh;
+	char m_Shown[BufferSize]; // Formatted value currently in m_Value
+	int m_iShownLength; // -1 until the first value is set
+};
@@ -0,0 +1,238 @@
+#include "JobSystem.h"
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+	thread_local int s_iThreadIndex = 0;
+}
+
+JobSystem::JobSystem(int iWorkerCount)
+	: m_uJobsInUse(0)
+	, m_iUnfinishedJobs(0)
+	, m_bRunning(true)
+{
+	if (iWorkerCount < 0) {
+		iWorkerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	for (int i = 0; i <= iWorkerCount; i++) {
+		m_Queues.push_back(std::make_unique<Queue>());
+	}
+
+	for (int i = 1; i <= iWorkerCount; i++) {
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	WaitForAll();
+
+	m_bRunning = false;
+	m_WakeCondition.notify_all();
+	for (std::thread& rWorker : m_Workers) {
+		rWorker.join();
+	}
+}
+
+int JobSystem::GetCurrentThreadIndex() {
+	return s_iThreadIndex;
+}
+
+JobSystem::JobHandle JobSystem::Schedule(JobFunction function, std::initializer_list<JobHandle> dependencies) {
+	Job* pJob = AllocateJob();
+	pJob->m_Function = std::move(function);
+	Submit(pJob, dependencies);
+	return pJob;
+}
+
+JobSystem::Job* JobSystem::AllocateJob() {
+	std::lock_guard<std::mutex> lock(m_JobStorageMutex);
+	if (m_uJobsInUse == m_JobPool.size()) {
+		m_JobPool.push_back(std::make_unique<Job>());
+	}
+	Job* pJob = m_JobPool[m_uJobsInUse++].get();
+	pJob->m_bFinished = false;
+	return pJob;
+}
+
+void JobSystem::Submit(Job* pJob, std::initializer_list<JobHandle> dependencies) {
+	// Hold one extra dependency while registering so the job cannot start half way through
+	pJob->m_iPendingDependencies = 1;
+	m_iUnfinishedJobs++;
+
+	for (Job* pDependency : dependencies) {
+		std::lock_guard<std::mutex> lock(pDependency->m_Mutex);
+		if (!pDependency->m_bFinished) {
+			pJob->m_iPendingDependencies++;
+			pDependency->m_Dependents.push_back(pJob);
+		}
+	}
+
+	if (--pJob->m_iPendingDependencies == 0) {
+		Enqueue(pJob);
+	}
+}
+
+void JobSystem::Wait(JobHandle job) {
+	const int iThreadIndex = s_iThreadIndex;
+	while (!job->m_bFinished) {
+		if (!RunOneJob(iThreadIndex)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(int iBegin, int iEnd, int iGrainSize, const RangeFunction& rFunction) {
+	if (iEnd <= iBegin) {
+		return;
+	}
+
+	iGrainSize = std::max(1, iGrainSize);
+	if (m_Workers.empty() || iEnd - iBegin <= iGrainSize) {
+		rFunction(iBegin, iEnd);
+		return;
+	}
+
+	// The chunks only reference this stack frame, which stays alive until all of them are done
+	std::atomic<int> iRemainingChunks((iEnd - iBegin + iGrainSize - 1) / iGrainSize);
+	for (int iChunkBegin = iBegin; iChunkBegin < iEnd; iChunkBegin += iGrainSize) {
+		Job* pJob = AllocateJob();
+		pJob->m_pRangeFunction = &rFunction;
+		pJob->m_iRangeBegin = iChunkBegin;
+		pJob->m_iRangeEnd = std::min(iEnd, iChunkBegin + iGrainSize);
+		pJob->m_pRemainingRanges = &iRemainingChunks;
+		Submit(pJob, {});
+	}
+
+	const int iThreadIndex = s_iThreadIndex;
+	while (iRemainingChunks > 0) {
+		if (!RunOneJob(iThreadIndex)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WaitForAll() {
+	const int iThreadIndex = s_iThreadIndex;
+	while (m_iUnfinishedJobs > 0) {
+		if (!RunOneJob(iThreadIndex)) {
+			std::this_thread::yield();
+		}
+	}
+
+	// Nothing references the jobs anymore, so they can be reused next frame
+	std::lock_guard<std::mutex> lock(m_JobStorageMutex);
+	for (size_t i = 0; i < m_uJobsInUse; i++) {
+		Job& rJob = *m_JobPool[i];
+		rJob.m_Function = nullptr;
+		rJob.m_pRangeFunction = nullptr;
+		rJob.m_pRemainingRanges = nullptr;
+		rJob.m_Dependents.clear(); // Keeps its capacity
+	}
+	m_uJobsInUse = 0;
+}
+
+void JobSystem::WorkerLoop(int iThreadIndex) {
+	s_iThreadIndex = iThreadIndex;
+	// Workers only ever run engine jobs
+	AllocationCounter::SetThreadTracked(true);
+	while (m_bRunning) {
+		if (RunOneJob(iThreadIndex)) {
+			continue;
+		}
+
+		// Nothing to do, sleep until a job is queued. The timeout covers a wake-up racing the check above.
+		std::unique_lock<std::mutex> lock(m_WakeMutex);
+		m_WakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+	}
+}
+
+void JobSystem::Enqueue(Job* pJob) {
+	Queue& rQueue = *m_Queues[s_iThreadIndex];
+	{
+		std::lock_guard<std::mutex> lock(rQueue.m_Mutex);
+		rQueue.PushBack(pJob);
+	}
+	m_WakeCondition.notify_one();
+}
+
+JobSystem::Job* JobSystem::PopOrSteal(int iThreadIndex) {
+	// Newest job of our own first, it is the most likely to still be in cache
+	{
+		Queue& rQueue = *m_Queues[iThreadIndex];
+		std::lock_guard<std::mutex> lock(rQueue.m_Mutex);
+		if (rQueue.m_uCount > 0) {
+			return rQueue.PopBack();
+		}
+	}
+
+	// Then the oldest job of someone else
+	const int iQueueCount = (int)m_Queues.size();
+	for (int i = 1; i < iQueueCount; i++) {
+		Queue& rQueue = *m_Queues[(iThreadIndex + i) % iQueueCount];
+		std::lock_guard<std::mutex> lock(rQueue.m_Mutex);
+		if (rQueue.m_uCount > 0) {
+			return rQueue.PopFront();
+		}
+	}
+	return nullptr;
+}
+
+bool JobSystem::RunOneJob(int iThreadIndex) {
+	Job* pJob = PopOrSteal(iThreadIndex);
+	if (!pJob) {
+		return false;
+	}
+	Execute(pJob);
+	return true;
+}
+
+void JobSystem::Execute(Job* pJob) {
+	if (pJob->m_pRangeFunction) {
+		(*pJob->m_pRangeFunction)(pJob->m_iRangeBegin, pJob->m_iRangeEnd);
+		(*pJob->m_pRemainingRanges)--;
+	}
+	else {
+		pJob->m_Function();
+	}
+
+	// Once finished no new dependents get added, so the list can be read without the lock
+	{
+		std::lock_guard<std::mutex> lock(pJob->m_Mutex);
+		pJob->m_bFinished = true;
+	}
+
+	for (Job* pDependent : pJob->m_Dependents) {
+		if (--pDependent->m_iPendingDependencies == 0) {
+			Enqueue(pDependent);
+		}
+	}
+	m_iUnfinishedJobs--;
+}
+
+void JobSystem::Queue::PushBack(Job* pJob) {
+	if (m_uCount == m_Jobs.size()) {
+		// Full, unroll the ring into a bigger buffer
+		std::vector<Job*> jobs(std::max<size_t>(64, m_Jobs.size() * 2));
+		for (size_t i = 0; i < m_uCount; i++) {
+			jobs[i] = m_Jobs[(m_uFront + i) % m_Jobs.size()];
+		}
+		m_Jobs.swap(jobs);
+		m_uFront = 0;
+	}
+	m_Jobs[(m_uFront + m_uCount) % m_Jobs.size()] = pJob;
+	m_uCount++;
+}
+
+JobSystem::Job* JobSystem::Queue::PopBack() {
+	m_uCount--;
+	return m_Jobs[(m_uFront + m_uCount) % m_Jobs.size()];
+}
+
+JobSystem::Job* JobSystem::Queue::PopFront() {
+	Job* pJob = m_Jobs[m_uFront];
+	m_uFront = (m_uFront + 1) % m_Jobs.size();
+	m_uCount--;
+	return pJob;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing thread pool. Every thread (the main thread included) owns a deque of jobs:
+// the owner pushes and pops at the back, idle threads steal from the front of the others.
+// A thread that waits for a job keeps running other jobs instead of blocking.
+// Jobs and queues are recycled, so once they have grown to a frame's worth of work
+// scheduling does not allocate.
+class JobSystem
+{
+	struct Job;
+public:
+	typedef std::function<void()> JobFunction;
+	typedef Job* JobHandle; // Valid until the next WaitForAll()
+	typedef std::function<void(int, int)> RangeFunction;
+
+	// iWorkerCount < 0 picks one worker per hardware thread besides the main thread
+	JobSystem(int iWorkerCount = -1);
+	~JobSystem();
+
+	// The job starts once every dependency has finished
+	JobHandle Schedule(JobFunction function, std::initializer_list<JobHandle> dependencies = {});
+	void Wait(JobHandle job);
+
+	// Splits [iBegin, iEnd) into chunks of at most iGrainSize and runs rFunction(iChunkBegin, iChunkEnd)
+	// for each of them across all threads. Returns when every chunk is done.
+	void ParallelFor(int iBegin, int iEnd, int iGrainSize, const RangeFunction& rFunction);
+
+	// Frame end barrier: runs and waits for every scheduled job, then recycles their storage
+	void WaitForAll();
+
+	// Worker threads plus the main thread
+	int GetThreadCount() const {
+		return (int)m_Queues.size();
+	}
+
+	// 0 on the main thread, 1..n on workers. Use it to index per-thread buffers.
+	static int GetCurrentThreadIndex();
+
+private:
+	struct Job {
+		JobFunction m_Function;
+		// ParallelFor chunks point at the caller's function instead of copying it into m_Function
+		const RangeFunction* m_pRangeFunction = nullptr;
+		int m_iRangeBegin = 0;
+		int m_iRangeEnd = 0;
+		std::atomic<int>* m_pRemainingRanges = nullptr;
+
+		std::atomic<int> m_iPendingDependencies;
+		std::atomic<bool> m_bFinished;
+		std::mutex m_Mutex; // Guards m_Dependents and the transition to finished
+		std::vector<Job*> m_Dependents;
+	};
+
+	// Ring buffer, the owner works at the back and thieves take from the front
+	struct Queue {
+		std::mutex m_Mutex;
+		std::vector<Job*> m_Jobs;
+		size_t m_uFront = 0;
+		size_t m_uCount = 0;
+
+		void PushBack(Job* pJob);
+		Job* PopBack();
+		Job* PopFront();
+	};
+
+	void WorkerLoop(int iThreadIndex);
+	Job* AllocateJob();
+	void Submit(Job* pJob, std::initializer_list<JobHandle> dependencies);
+	void Enqueue(Job* pJob);
+	Job* PopOrSteal(int iThreadIndex);
+	bool RunOneJob(int iThreadIndex);
+	void Execute(Job* pJob);
+
+	std::vector<std::unique_ptr<Queue>> m_Queues; // One per thread, index 0 is the main thread
+	std::vector<std::thread> m_Workers;
+
+	std::mutex m_JobStorageMutex;
+	std::vector<std::unique_ptr<Job>> m_JobPool; // Jobs never move, so handles stay valid while it grows
+	size_t m_uJobsInUse;
+
+	std::atomic<int> m_iUnfinishedJobs;
+	std::atomic<bool> m_bRunning;
+
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+};
@@ -0,0 +1,226 @@
+#include "PathGraph.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+	// North, east, south, west
+	const sf::Vector2i DirectionOffsets[PathGraph::DirectionCount] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+}
+
+void PathGraph::Clear() {
+	m_Coords.clear();
+	m_Neighbors.clear();
+	m_NodeByCoords.clear();
+	m_iSink = -1;
+}
+
+int PathGraph::AddNode(const sf::Vector2i& vCoords) {
+	const int iExisting = FindNode(vCoords);
+	if (iExisting >= 0) {
+		return iExisting;
+	}
+
+	const int iNode = (int)m_Coords.size();
+	m_Coords.push_back(vCoords);
+	m_NodeByCoords[GetKey(vCoords)] = iNode;
+	return iNode;
+}
+
+void PathGraph::Build() {
+	m_Neighbors.assign(m_Coords.size() * DirectionCount, -1);
+	for (int iNode = 0; iNode < GetNodeCount(); iNode++) {
+		UpdateEdges(m_Coords[iNode]);
+	}
+}
+
+int PathGraph::InsertNode(const sf::Vector2i& vCoords) {
+	const int iExisting = FindNode(vCoords);
+	if (iExisting >= 0) {
+		return iExisting;
+	}
+
+	const int iNode = AddNode(vCoords);
+	m_Neighbors.resize(m_Coords.size() * DirectionCount, -1);
+	UpdateEdgesAround(vCoords);
+	return iNode;
+}
+
+bool PathGraph::RemoveNode(const sf::Vector2i& vCoords) {
+	const int iNode = FindNode(vCoords);
+	if (iNode < 0) {
+		return false;
+	}
+
+	// The last node takes over the freed index, only its grid neighbours can point at it
+	const int iLast = GetNodeCount() - 1;
+	m_NodeByCoords.erase(GetKey(vCoords));
+	if (iNode != iLast) {
+		m_Coords[iNode] = m_Coords[iLast];
+		std::copy_n(m_Neighbors.begin() + iLast * DirectionCount, DirectionCount, m_Neighbors.begin() + iNode * DirectionCount);
+		m_NodeByCoords[GetKey(m_Coords[iNode])] = iNode;
+		for (const sf::Vector2i& vOffset : DirectionOffsets) {
+			const int iNeighbor = FindNode(m_Coords[iNode] + vOffset);
+			if (iNeighbor < 0) continue;
+
+			for (int iDirection = 0; iDirection < DirectionCount; iDirection++) {
+				int& rTarget = m_Neighbors[iNeighbor * DirectionCount + iDirection];
+				if (rTarget == iLast) {
+					rTarget = iNode;
+				}
+			}
+		}
+	}
+	m_Coords.pop_back();
+	m_Neighbors.resize(m_Coords.size() * DirectionCount);
+
+	if (m_iSink == iNode) {
+		m_iSink = -1;
+	}
+	else if (m_iSink == iLast) {
+		m_iSink = iNode;
+	}
+	UpdateEdgesAround(vCoords);
+	return true;
+}
+
+int PathGraph::FindNode(const sf::Vector2i& vCoords) const {
+	const auto it = m_NodeByCoords.find(GetKey(vCoords));
+	return it != m_NodeByCoords.end() ? it->second : -1;
+}
+
+void PathGraph::MakeSink(int iNode) {
+	m_iSink = iNode;
+	UpdateEdgesAround(m_Coords[iNode]);
+}
+
+void PathGraph::UpdateEdges(const sf::Vector2i& vCoords) {
+	const int iNode = FindNode(vCoords);
+	if (iNode < 0) {
+		return;
+	}
+
+	// A neighbour of the sink only leads into it
+	const bool bNextToSink = m_iSink >= 0 && iNode != m_iSink
+		&& std::abs(vCoords.x - m_Coords[m_iSink].x) + std::abs(vCoords.y - m_Coords[m_iSink].y) == 1;
+	for (int iDirection = 0; iDirection < DirectionCount; iDirection++) {
+		const int iNeighbor = FindNode(vCoords + DirectionOffsets[iDirection]);
+		m_Neighbors[iNode * DirectionCount + iDirection] = !bNextToSink || iNeighbor == m_iSink ? iNeighbor : -1;
+	}
+}
+
+void PathGraph::UpdateEdgesAround(const sf::Vector2i& vCoords) {
+	UpdateEdges(vCoords);
+	for (const sf::Vector2i& vOffset : DirectionOffsets) {
+		UpdateEdges(vCoords + vOffset);
+	}
+}
+
+int PathGraph::GetDirection(int iFrom, int iTo) const {
+	for (int iDirection = 0; iDirection < DirectionCount; iDirection++) {
+		if (m_Neighbors[iFrom * DirectionCount + iDirection] == iTo) {
+			return iDirection;
+		}
+	}
+	return -1;
+}
+
+bool PathGraph::FindShortestRoute(int iStart, int iGoal, Route& rOutRoute) const {
+	return FindShortestRoute(iStart, iGoal, nullptr, rOutRoute);
+}
+
+bool PathGraph::FindShortestRoute(int iStart, int iGoal, const SearchMask* pMask, Route& rOutRoute) const {
+	rOutRoute.clear();
+	if (iStart < 0 || iGoal < 0) {
+		return false;
+	}
+
+	// Every step costs the same, so the first time the search reaches a node it took the fewest steps.
+	// Neighbours are always visited in the same order, which keeps ties deterministic.
+	std::vector<int> previous(m_Coords.size(), -1);
+	std::vector<int> frontier;
+	frontier.push_back(iStart);
+	previous[iStart] = iStart;
+
+	for (size_t uNext = 0; uNext < frontier.size() && previous[iGoal] < 0; uNext++) {
+		const int iNode = frontier[uNext];
+		for (int iDirection = 0; iDirection < DirectionCount; iDirection++) {
+			const int iNeighbor = m_Neighbors[iNode * DirectionCount + iDirection];
+			if (iNeighbor < 0 || previous[iNeighbor] >= 0) continue;
+			if (pMask && (pMask->m_BlockedNodes[iNeighbor] || (pMask->m_BlockedDirections[iNode] & (1 << iDirection)))) continue;
+
+			previous[iNeighbor] = iNode;
+			frontier.push_back(iNeighbor);
+		}
+	}
+
+	if (previous[iGoal] < 0) {
+		return false;
+	}
+
+	for (int iNode = iGoal; iNode != iStart; iNode = previous[iNode]) {
+		rOutRoute.push_back(iNode);
+	}
+	rOutRoute.push_back(iStart);
+	std::reverse(rOutRoute.begin(), rOutRoute.end());
+	return true;
+}
+
+int PathGraph::FindShortestRoutes(int iStart, int iGoal, int iMaxRoutes, std::vector<Route>& rOutRoutes) const {
+	rOutRoutes.clear();
+	if (iMaxRoutes <= 0) {
+		return 0;
+	}
+
+	Route route;
+	if (!FindShortestRoute(iStart, iGoal, route)) {
+		return 0;
+	}
+	rOutRoutes.push_back(route);
+
+	// Yen's algorithm: every next route leaves the previous one at some spur node. The part before the
+	// spur is kept, the edges other routes took from there and the kept nodes are blocked, and the
+	// rest is searched again. The shortest of all candidates becomes the next route.
+	std::vector<Route> candidates;
+	SearchMask mask;
+	Route spurRoute;
+	while ((int)rOutRoutes.size() < iMaxRoutes) {
+		const Route& rPrevious = rOutRoutes.back();
+		for (size_t uSpur = 0; uSpur + 1 < rPrevious.size(); uSpur++) {
+			mask.m_BlockedNodes.assign(m_Coords.size(), 0);
+			mask.m_BlockedDirections.assign(m_Coords.size(), 0);
+
+			const int iSpurNode = rPrevious[uSpur];
+			for (const Route& rRoute : rOutRoutes) {
+				if (rRoute.size() > uSpur + 1 && std::equal(rPrevious.begin(), rPrevious.begin() + uSpur + 1, rRoute.begin())) {
+					mask.m_BlockedDirections[iSpurNode] |= 1 << GetDirection(iSpurNode, rRoute[uSpur + 1]);
+				}
+			}
+			for (size_t uRoot = 0; uRoot < uSpur; uRoot++) {
+				mask.m_BlockedNodes[rPrevious[uRoot]] = 1;
+			}
+
+			if (!FindShortestRoute(iSpurNode, iGoal, &mask, spurRoute)) {
+				continue;
+			}
+
+			Route candidate(rPrevious.begin(), rPrevious.begin() + uSpur);
+			candidate.insert(candidate.end(), spurRoute.begin(), spurRoute.end());
+			if (std::find(candidates.begin(), candidates.end(), candidate) == candidates.end()
+				&& std::find(rOutRoutes.begin(), rOutRoutes.end(), candidate) == rOutRoutes.end()) {
+				candidates.push_back(candidate);
+			}
+		}
+
+		if (candidates.empty()) {
+			break;
+		}
+
+		// Shortest candidate next, equal lengths in a fixed order
+		auto best = std::min_element(candidates.begin(), candidates.end(), [](const Route& rA, const Route& rB) {
+			return rA.size() != rB.size() ? rA.size() < rB.size() : rA < rB;
+			});
+		rOutRoutes.push_back(*best);
+		candidates.erase(best);
+	}
+	return (int)rOutRoutes.size();
+}
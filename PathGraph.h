@@ -0,0 +1,79 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <unordered_map>
+#include <vector>
+
+// Graph over grid cells where every node connects to the nodes north, east, south and west of it.
+// Routes are found with a breadth first search, every step costs the same. Alternative routes come
+// from Yen's k shortest paths, which only ever runs a bounded number of searches instead of
+// enumerating every simple path.
+class PathGraph
+{
+public:
+	typedef std::vector<int> Route; // Node indices from the start to the goal
+
+	static constexpr int DirectionCount = 4;
+
+	void Clear();
+
+	// Returns the node already at vCoords if there is one
+	int AddNode(const sf::Vector2i& vCoords);
+
+	// Connects neighbouring nodes, call it after the last AddNode()
+	void Build();
+
+	// Add or remove a single node of a built graph, only the edges around it are updated.
+	// InsertNode() returns the node already at vCoords if there is one, RemoveNode() false if there is none.
+	// Removing moves the last node into the freed index.
+	int InsertNode(const sf::Vector2i& vCoords);
+	bool RemoveNode(const sf::Vector2i& vCoords);
+
+	// -1 if no node is at vCoords
+	int FindNode(const sf::Vector2i& vCoords) const;
+
+	// Every neighbour of iNode leads only into it, so routes passing next to a goal enter it instead of walking past.
+	// Stays in effect for nodes inserted later.
+	void MakeSink(int iNode);
+
+	int GetNodeCount() const {
+		return (int)m_Coords.size();
+	}
+
+	const sf::Vector2i& GetCoords(int iNode) const {
+		return m_Coords[iNode];
+	}
+
+	// Node reached from iNode in iDirection (north, east, south, west), -1 if there is no edge
+	int GetNeighbor(int iNode, int iDirection) const {
+		return m_Neighbors[iNode * DirectionCount + iDirection];
+	}
+
+	// Fewest steps from iStart to iGoal, false if the goal cannot be reached
+	bool FindShortestRoute(int iStart, int iGoal, Route& rOutRoute) const;
+
+	// Up to iMaxRoutes loopless routes, shortest first. Fills rOutRoutes and returns how many were found.
+	int FindShortestRoutes(int iStart, int iGoal, int iMaxRoutes, std::vector<Route>& rOutRoutes) const;
+
+private:
+	// Search state for one route, nodes and edges can be excluded for Yen's spur searches
+	struct SearchMask {
+		std::vector<char> m_BlockedNodes;
+		std::vector<unsigned char> m_BlockedDirections; // Bit per direction, indexed by node
+	};
+
+	bool FindShortestRoute(int iStart, int iGoal, const SearchMask* pMask, Route& rOutRoute) const;
+	int GetDirection(int iFrom, int iTo) const;
+
+	// Sets the edges leading out of the node at vCoords, if there is one
+	void UpdateEdges(const sf::Vector2i& vCoords);
+	void UpdateEdgesAround(const sf::Vector2i& vCoords);
+
+	static long long GetKey(const sf::Vector2i& vCoords) {
+		return (long long)vCoords.x << 32 | (unsigned)vCoords.y;
+	}
+
+	std::vector<sf::Vector2i> m_Coords;
+	std::vector<int> m_Neighbors; // DirectionCount per node, -1 where there is none
+	std::unordered_map<long long, int> m_NodeByCoords;
+	int m_iSink = -1;
+};
@@ -0,0 +1,457 @@
+#include "PhysicsWorld.h"
+#include "MathHelpers.h"
+#include "CollisionKernels.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+	struct ShapeParams {
+		sf::Vector2f m_vPosition;
+		float m_fRadius;
+		sf::Vector2f m_vHalfSize;
+	};
+
+	// Every handler fills the manifold with the normal from A to B and how deep they overlap.
+	// The sqrt is only taken once the squared distances say the shapes touch.
+	typedef bool (*ContactFunction)(const ShapeParams& rA, const ShapeParams& rB, PhysicsWorld::Manifold& rOutManifold);
+
+	bool CircleVsCircle(const ShapeParams& rA, const ShapeParams& rB, PhysicsWorld::Manifold& rOutManifold) {
+		const sf::Vector2f vAToB = rB.m_vPosition - rA.m_vPosition;
+		const float fSumOfRadii = rA.m_fRadius + rB.m_fRadius;
+		if (vAToB.x * vAToB.x + vAToB.y * vAToB.y >= fSumOfRadii * fSumOfRadii) {
+			return false;
+		}
+
+		rOutManifold.m_vNormal = MathHelpers::normalize(vAToB);
+		rOutManifold.m_fDepth = fSumOfRadii - MathHelpers::flength(vAToB);
+		return true;
+	}
+
+	bool CircleVsRectangle(const ShapeParams& rA, const ShapeParams& rB, PhysicsWorld::Manifold& rOutManifold) {
+		float fClosestX = std::clamp(rA.m_vPosition.x, rB.m_vPosition.x - rB.m_vHalfSize.x, rB.m_vPosition.x + rB.m_vHalfSize.x);
+		float fClosestY = std::clamp(rA.m_vPosition.y, rB.m_vPosition.y - rB.m_vHalfSize.y, rB.m_vPosition.y + rB.m_vHalfSize.y);
+
+		const sf::Vector2f vCircleToClosestPoint = sf::Vector2f(fClosestX, fClosestY) - rA.m_vPosition;
+		if (vCircleToClosestPoint.x * vCircleToClosestPoint.x + vCircleToClosestPoint.y * vCircleToClosestPoint.y >= rA.m_fRadius * rA.m_fRadius) {
+			return false;
+		}
+
+		rOutManifold.m_vNormal = MathHelpers::normalize(vCircleToClosestPoint);
+		rOutManifold.m_fDepth = rA.m_fRadius - MathHelpers::flength(vCircleToClosestPoint);
+		return true;
+	}
+
+	bool RectangleVsCircle(const ShapeParams& rA, const ShapeParams& rB, PhysicsWorld::Manifold& rOutManifold) {
+		if (!CircleVsRectangle(rB, rA, rOutManifold)) {
+			return false;
+		}
+		rOutManifold.m_vNormal = -rOutManifold.m_vNormal;
+		return true;
+	}
+
+	bool RectangleVsRectangle(const ShapeParams& rA, const ShapeParams& rB, PhysicsWorld::Manifold& rOutManifold) {
+		float fOverlapX = rA.m_vHalfSize.x + rB.m_vHalfSize.x - std::abs(rA.m_vPosition.x - rB.m_vPosition.x);
+		float fOverlapY = rA.m_vHalfSize.y + rB.m_vHalfSize.y - std::abs(rA.m_vPosition.y - rB.m_vPosition.y);
+		if (fOverlapX <= 0 || fOverlapY <= 0) {
+			return false;
+		}
+
+		// Separate along the axis with the smallest overlap
+		if (fOverlapX < fOverlapY) {
+			rOutManifold.m_vNormal = sf::Vector2f(rA.m_vPosition.x < rB.m_vPosition.x ? 1.0f : -1.0f, 0.0f);
+			rOutManifold.m_fDepth = fOverlapX;
+		}
+		else {
+			rOutManifold.m_vNormal = sf::Vector2f(0.0f, rA.m_vPosition.y < rB.m_vPosition.y ? 1.0f : -1.0f);
+			rOutManifold.m_fDepth = fOverlapY;
+		}
+		return true;
+	}
+
+	// Indexed by [ShapeA][ShapeB]
+	constexpr ContactFunction ContactFunctions[2][2] = {
+		{ CircleVsCircle, CircleVsRectangle },
+		{ RectangleVsCircle, RectangleVsRectangle }
+	};
+	static_assert((int)PhysicsWorld::Shape::Circle == 0 && (int)PhysicsWorld::Shape::Rectangle == 1, "ContactFunctions is indexed by Shape");
+
+	bool GenerateShapeContact(PhysicsWorld::Shape eShapeA, const ShapeParams& rA, PhysicsWorld::Shape eShapeB, const ShapeParams& rB, PhysicsWorld::Manifold& rOutManifold) {
+		return ContactFunctions[(int)eShapeA][(int)eShapeB](rA, rB, rOutManifold);
+	}
+}
+
+PhysicsWorld::PhysicsWorld()
+	: m_bStaticBroadphaseDirty(false)
+	, m_bBruteForceBroadphase(false)
+	, m_pJobSystem(nullptr)
+{
+	for (int iLayer = 0; iLayer < LayerCount; iLayer++) {
+		m_LayerCollisionMask[iLayer] = LayerGroupCount - 1;
+	}
+	RebuildLayerGroupCollisionMasks();
+
+	// One broadphase cell per map tile
+	for (int iGroup = 0; iGroup < LayerGroupCount; iGroup++) {
+		m_LayerBroadphase[iGroup].SetCellSize(160.0f);
+		m_StaticLayerBroadphase[iGroup].SetCellSize(160.0f);
+	}
+}
+
+PhysicsWorld::BodyId PhysicsWorld::CreateBody(const BodyDef& rDef, const sf::Vector2f& vPosition) {
+	BodyId bodyId;
+	if (!m_FreeIds.empty()) {
+		bodyId = m_FreeIds.back();
+		m_FreeIds.pop_back();
+	}
+	else {
+		bodyId = (BodyId)m_IdToIndex.size();
+		m_IdToIndex.push_back(-1);
+	}
+	assert(rDef.m_iLayers >= 0 && rDef.m_iLayers < LayerGroupCount);
+
+	m_IdToIndex[bodyId] = (int)m_PositionX.size();
+	m_IndexToId.push_back(bodyId);
+
+	m_PositionX.push_back(vPosition.x);
+	m_PositionY.push_back(vPosition.y);
+	m_PreviousPositionX.push_back(vPosition.x);
+	m_PreviousPositionY.push_back(vPosition.y);
+	m_Rotation.push_back(0.0f);
+	m_PreviousRotation.push_back(0.0f);
+	m_AngularVelocity.push_back(0.0f);
+	m_VelocityX.push_back(0.0f);
+	m_VelocityY.push_back(0.0f);
+	m_ImpulseX.push_back(0.0f);
+	m_ImpulseY.push_back(0.0f);
+	m_Radius.push_back(rDef.m_fRadius);
+	m_HalfWidth.push_back(rDef.m_fWidth / 2);
+	m_HalfHeight.push_back(rDef.m_fHeight / 2);
+	m_Layers.push_back(rDef.m_iLayers);
+	m_Shape.push_back(rDef.m_eShape);
+	m_Type.push_back(rDef.m_eType);
+
+	if (rDef.m_eType == Type::Static) {
+		m_bStaticBroadphaseDirty = true;
+	}
+	return bodyId;
+}
+
+void PhysicsWorld::DestroyBody(BodyId bodyId) {
+	assert(IsValid(bodyId));
+	const int iIndex = m_IdToIndex[bodyId];
+	if (m_Type[iIndex] == Type::Static) {
+		m_bStaticBroadphaseDirty = true;
+	}
+
+	// Move the last body into the freed slot to keep the arrays dense
+	auto SwapRemove = [iIndex](auto& rArray) {
+		rArray[iIndex] = rArray.back();
+		rArray.pop_back();
+	};
+	SwapRemove(m_PositionX);
+	SwapRemove(m_PositionY);
+	SwapRemove(m_PreviousPositionX);
+	SwapRemove(m_PreviousPositionY);
+	SwapRemove(m_Rotation);
+	SwapRemove(m_PreviousRotation);
+	SwapRemove(m_AngularVelocity);
+	SwapRemove(m_VelocityX);
+	SwapRemove(m_VelocityY);
+	SwapRemove(m_ImpulseX);
+	SwapRemove(m_ImpulseY);
+	SwapRemove(m_Radius);
+	SwapRemove(m_HalfWidth);
+	SwapRemove(m_HalfHeight);
+	SwapRemove(m_Layers);
+	SwapRemove(m_Shape);
+	SwapRemove(m_Type);
+	SwapRemove(m_IndexToId);
+
+	if (iIndex < (int)m_IndexToId.size()) {
+		m_IdToIndex[m_IndexToId[iIndex]] = iIndex;
+	}
+	m_IdToIndex[bodyId] = -1;
+	m_FreeIds.push_back(bodyId);
+}
+
+void PhysicsWorld::Clear() {
+	m_PositionX.clear();
+	m_PositionY.clear();
+	m_PreviousPositionX.clear();
+	m_PreviousPositionY.clear();
+	m_Rotation.clear();
+	m_PreviousRotation.clear();
+	m_AngularVelocity.clear();
+	m_VelocityX.clear();
+	m_VelocityY.clear();
+	m_ImpulseX.clear();
+	m_ImpulseY.clear();
+	m_Radius.clear();
+	m_HalfWidth.clear();
+	m_HalfHeight.clear();
+	m_Layers.clear();
+	m_Shape.clear();
+	m_Type.clear();
+	m_IndexToId.clear();
+	m_IdToIndex.clear();
+	m_FreeIds.clear();
+	m_Contacts.clear();
+	m_bStaticBroadphaseDirty = true;
+}
+
+void PhysicsWorld::SetLayersCollide(int iLayersA, int iLayersB, bool bCollide) {
+	for (int iLayerA = 0; iLayerA < LayerCount; iLayerA++) {
+		for (int iLayerB = 0; iLayerB < LayerCount; iLayerB++) {
+			if ((iLayersA & (1 << iLayerA)) == 0 || (iLayersB & (1 << iLayerB)) == 0) continue;
+
+			// Keep the matrix symmetric
+			if (bCollide) {
+				m_LayerCollisionMask[iLayerA] |= 1 << iLayerB;
+				m_LayerCollisionMask[iLayerB] |= 1 << iLayerA;
+			}
+			else {
+				m_LayerCollisionMask[iLayerA] &= ~(1 << iLayerB);
+				m_LayerCollisionMask[iLayerB] &= ~(1 << iLayerA);
+			}
+		}
+	}
+	RebuildLayerGroupCollisionMasks();
+}
+
+void PhysicsWorld::RebuildLayerGroupCollisionMasks() {
+	for (int iGroup = 0; iGroup < LayerGroupCount; iGroup++) {
+		m_LayerGroupCollisionMask[iGroup] = 0;
+		for (int iLayer = 0; iLayer < LayerCount; iLayer++) {
+			if ((iGroup & (1 << iLayer)) != 0) {
+				m_LayerGroupCollisionMask[iGroup] |= m_LayerCollisionMask[iLayer];
+			}
+		}
+	}
+}
+
+void PhysicsWorld::QueryStaticBodies(const sf::FloatRect& rBounds, int iLayers, std::vector<BodyId>& rOutBodies) {
+	if (m_bStaticBroadphaseDirty) {
+		RebuildStaticBroadphase();
+	}
+
+	for (int iGroup = 1; iGroup < LayerGroupCount; iGroup++) {
+		if ((iGroup & iLayers) != 0 && m_StaticLayerBroadphase[iGroup].GetEntryCount() > 0) {
+			m_StaticLayerBroadphase[iGroup].Query(rBounds, rOutBodies);
+		}
+	}
+}
+
+void PhysicsWorld::RebuildStaticBroadphase() {
+	for (SpatialHashGrid& rGrid : m_StaticLayerBroadphase) {
+		rGrid.Clear();
+	}
+	for (int i = 0; i < GetBodyCount(); i++) {
+		if (m_Type[i] == Type::Static) {
+			m_StaticLayerBroadphase[m_Layers[i]].Insert(m_IndexToId[i], GetBoundsAtIndex(i));
+		}
+	}
+	for (SpatialHashGrid& rGrid : m_StaticLayerBroadphase) {
+		rGrid.Build();
+	}
+	m_bStaticBroadphaseDirty = false;
+}
+
+bool PhysicsWorld::AreShapesOverlapping(const BodyDef& rDefA, const sf::Vector2f& vPositionA, const BodyDef& rDefB, const sf::Vector2f& vPositionB) {
+	Manifold manifold;
+	return GenerateShapeContact(rDefA.m_eShape, { vPositionA, rDefA.m_fRadius, sf::Vector2f(rDefA.m_fWidth / 2, rDefA.m_fHeight / 2) },
+		rDefB.m_eShape, { vPositionB, rDefB.m_fRadius, sf::Vector2f(rDefB.m_fWidth / 2, rDefB.m_fHeight / 2) }, manifold);
+}
+
+sf::FloatRect PhysicsWorld::GetBoundsAtIndex(int i) const {
+	if (m_Shape[i] == Shape::Circle) {
+		return sf::FloatRect(m_PositionX[i] - m_Radius[i], m_PositionY[i] - m_Radius[i], m_Radius[i] * 2, m_Radius[i] * 2);
+	}
+	return sf::FloatRect(m_PositionX[i] - m_HalfWidth[i], m_PositionY[i] - m_HalfHeight[i], m_HalfWidth[i] * 2, m_HalfHeight[i] * 2);
+}
+
+void PhysicsWorld::Step(float fDeltaTime) {
+	m_Contacts.clear();
+	const int iBodyCount = GetBodyCount();
+
+	// Keep the last state around so rendering can interpolate between the two
+	m_PreviousPositionX = m_PositionX;
+	m_PreviousPositionY = m_PositionY;
+	m_PreviousRotation = m_Rotation;
+
+	for (int i = 0; i < iBodyCount; i++) {
+		m_Rotation[i] += m_AngularVelocity[i] * fDeltaTime;
+		if (m_Rotation[i] >= 360.0f) {
+			// Wrap both states together so the interpolation does not spin backwards
+			m_Rotation[i] -= 360.0f;
+			m_PreviousRotation[i] -= 360.0f;
+		}
+	}
+
+	// Move every dynamic body first so the broadphase sees this update's positions
+	for (int i = 0; i < iBodyCount; i++) {
+		if (m_Type[i] == Type::Dynamic) {
+			m_PositionX[i] += m_VelocityX[i] * fDeltaTime + m_ImpulseX[i];
+			m_PositionY[i] += m_VelocityY[i] * fDeltaTime + m_ImpulseY[i];
+			m_ImpulseX[i] = 0.0f;
+			m_ImpulseY[i] = 0.0f;
+		}
+	}
+
+	if (!m_bBruteForceBroadphase) {
+		if (m_bStaticBroadphaseDirty) {
+			RebuildStaticBroadphase();
+		}
+
+		for (SpatialHashGrid& rGrid : m_LayerBroadphase) {
+			rGrid.Clear();
+		}
+		for (int i = 0; i < iBodyCount; i++) {
+			if (m_Type[i] == Type::Dynamic) {
+				m_LayerBroadphase[m_Layers[i]].Insert(i, GetBoundsAtIndex(i));
+			}
+		}
+		for (SpatialHashGrid& rGrid : m_LayerBroadphase) {
+			rGrid.Build();
+		}
+	}
+
+	// Finding candidates only reads the world, so it runs on every thread. Resolving them moves
+	// bodies and stays on this thread.
+	const int iChunkCount = (iBodyCount + BroadphaseGrainSize - 1) / BroadphaseGrainSize;
+	if ((int)m_CandidateChunks.size() < iChunkCount) {
+		m_CandidateChunks.resize(iChunkCount);
+	}
+	for (int iChunk = 0; iChunk < iChunkCount; iChunk++) {
+		m_CandidateChunks[iChunk].m_Bodies.clear();
+		m_CandidateChunks[iChunk].m_CandidateEnds.clear();
+		m_CandidateChunks[iChunk].m_Candidates.clear();
+	}
+
+	if (m_pJobSystem) {
+		m_pJobSystem->ParallelFor(0, iBodyCount, BroadphaseGrainSize, [this](int iBegin, int iEnd) {
+			GatherCandidates(iBegin, iEnd, m_CandidateChunks[iBegin / BroadphaseGrainSize]);
+			});
+	}
+	else if (iChunkCount > 0) {
+		GatherCandidates(0, iBodyCount, m_CandidateChunks[0]);
+	}
+
+	for (int iChunk = 0; iChunk < iChunkCount; iChunk++) {
+		const CandidateChunk& rChunk = m_CandidateChunks[iChunk];
+		int iCandidateBegin = 0;
+		for (int iBody = 0; iBody < (int)rChunk.m_Bodies.size(); iBody++) {
+			const int iCandidateEnd = rChunk.m_CandidateEnds[iBody];
+			ResolveCandidates(rChunk.m_Bodies[iBody], rChunk.m_Candidates.data() + iCandidateBegin, iCandidateEnd - iCandidateBegin);
+			iCandidateBegin = iCandidateEnd;
+		}
+	}
+}
+
+void PhysicsWorld::GatherCandidates(int iBegin, int iEnd, CandidateChunk& rChunk) const {
+	const int iBodyCount = GetBodyCount();
+	for (int i = iBegin; i < iEnd; i++) {
+		if (m_Type[i] != Type::Dynamic) continue;
+
+		// Only bodies from neighbouring cells, in layers we collide with, can touch us
+		rChunk.m_QueryResults.clear();
+		if (m_bBruteForceBroadphase) {
+			for (int j = 0; j < iBodyCount; j++) {
+				if (DoLayersCollide(m_Layers[i], m_Layers[j])) {
+					rChunk.m_QueryResults.push_back(j);
+				}
+			}
+		}
+		else {
+			const int iCollidingLayers = m_LayerGroupCollisionMask[m_Layers[i]];
+			const sf::FloatRect bounds = GetBoundsAtIndex(i);
+			rChunk.m_StaticQueryResults.clear();
+			for (int iGroup = 1; iGroup < LayerGroupCount; iGroup++) {
+				if ((iGroup & iCollidingLayers) == 0) continue;
+
+				if (m_LayerBroadphase[iGroup].GetEntryCount() > 0) {
+					m_LayerBroadphase[iGroup].Query(bounds, rChunk.m_QueryResults);
+				}
+				if (m_StaticLayerBroadphase[iGroup].GetEntryCount() > 0) {
+					m_StaticLayerBroadphase[iGroup].Query(bounds, rChunk.m_StaticQueryResults);
+				}
+			}
+
+			// The static grids hold body ids
+			for (BodyId staticBody : rChunk.m_StaticQueryResults) {
+				rChunk.m_QueryResults.push_back(m_IdToIndex[staticBody]);
+			}
+		}
+
+		for (int j : rChunk.m_QueryResults) {
+			if (i == j) continue; // Skip self-collision
+			// A pair of dynamic bodies is handled once, from the lower index
+			if (m_Type[j] == Type::Dynamic && j < i) continue;
+			rChunk.m_Candidates.push_back(j);
+		}
+
+		rChunk.m_Bodies.push_back(i);
+		rChunk.m_CandidateEnds.push_back((int)rChunk.m_Candidates.size());
+	}
+}
+
+void PhysicsWorld::ResolveCandidates(int i, const int* pCandidates, int iCandidateCount) {
+	if (m_Shape[i] == Shape::Rectangle) {
+		// There is no batched kernel for rectangles, test the pairs right away
+		for (int iCandidate = 0; iCandidate < iCandidateCount; iCandidate++) {
+			ResolvePair(i, pCandidates[iCandidate]);
+		}
+		return;
+	}
+
+	m_CircleBatch.Clear();
+	m_RectangleBatch.Clear();
+	for (int iCandidate = 0; iCandidate < iCandidateCount; iCandidate++) {
+		const int j = pCandidates[iCandidate];
+		if (m_Shape[j] == Shape::Circle) {
+			m_CircleBatch.Add(j, m_PositionX[j], m_PositionY[j], m_Radius[j], 0.0f, 0.0f);
+		}
+		else {
+			m_RectangleBatch.Add(j, m_PositionX[j], m_PositionY[j], 0.0f, m_HalfWidth[j], m_HalfHeight[j]);
+		}
+	}
+
+	// Test against all gathered candidates at once, then resolve the hits
+	m_BatchHits.resize(std::max(m_CircleBatch.m_Indices.size(), m_RectangleBatch.m_Indices.size()));
+
+	int iHitCount = CollisionKernels::CircleVsCircles(m_PositionX[i], m_PositionY[i], m_Radius[i],
+		m_CircleBatch.m_X.data(), m_CircleBatch.m_Y.data(), m_CircleBatch.m_Radius.data(), (int)m_CircleBatch.m_Indices.size(), m_BatchHits.data());
+	for (int iHit = 0; iHit < iHitCount; iHit++) {
+		ResolvePair(i, m_CircleBatch.m_Indices[m_BatchHits[iHit]]);
+	}
+
+	iHitCount = CollisionKernels::CircleVsRectangles(m_PositionX[i], m_PositionY[i], m_Radius[i],
+		m_RectangleBatch.m_X.data(), m_RectangleBatch.m_Y.data(), m_RectangleBatch.m_HalfWidth.data(), m_RectangleBatch.m_HalfHeight.data(),
+		(int)m_RectangleBatch.m_Indices.size(), m_BatchHits.data());
+	for (int iHit = 0; iHit < iHitCount; iHit++) {
+		ResolvePair(i, m_RectangleBatch.m_Indices[m_BatchHits[iHit]]);
+	}
+}
+
+void PhysicsWorld::ResolvePair(int iA, int iB) {
+	assert(m_Type[iA] != Type::Static);
+	Manifold manifold;
+	if (!GenerateShapeContact(m_Shape[iA], { sf::Vector2f(m_PositionX[iA], m_PositionY[iA]), m_Radius[iA], sf::Vector2f(m_HalfWidth[iA], m_HalfHeight[iA]) },
+		m_Shape[iB], { sf::Vector2f(m_PositionX[iB], m_PositionY[iB]), m_Radius[iB], sf::Vector2f(m_HalfWidth[iB], m_HalfHeight[iB]) }, manifold)) {
+		return;
+	}
+
+	// The contact reports the manifold from before the bodies were pushed apart
+	m_Contacts.push_back({ m_IndexToId[iA], m_IndexToId[iB], manifold });
+
+	const sf::Vector2f vPush = manifold.m_vNormal * manifold.m_fDepth;
+	if (m_Type[iB] == Type::Dynamic) {
+		// Both bodies are dynamic, each moves half of the way
+		MoveBody(iA, -vPush * 0.5f);
+		MoveBody(iB, vPush * 0.5f);
+	}
+	else {
+		// We only need to move A
+		MoveBody(iA, -vPush);
+	}
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "SpatialHashGrid.h"
+
+class JobSystem;
+
+// Owns the physics state of every body in parallel arrays, so the collision loops walk
+// small contiguous arrays instead of whole entities. Bodies are addressed by a stable
+// BodyId which maps to a dense index, removing a body swaps the last one into its slot.
+class PhysicsWorld
+{
+public:
+	typedef int BodyId;
+	static constexpr BodyId InvalidBody = -1;
+
+	enum Layer {
+		Enemy = 1, //0b0001
+		Tower = 2, //0b0010
+		Projectile = 4 // 0b0100
+	};
+	static constexpr int LayerCount = 3;
+	static constexpr int LayerGroupCount = 1 << LayerCount; // Every combination of layers
+
+	enum class Shape : unsigned char {
+		Circle,
+		Rectangle
+	};
+
+	enum class Type : unsigned char {
+		Static,
+		Dynamic
+	};
+
+	// Description of a body, spawn templates keep one of these instead of a live body
+	struct BodyDef {
+		Shape m_eShape = Shape::Circle;
+		Type m_eType = Type::Static;
+		float m_fRadius = 0.0f; // For Circle shape
+		float m_fWidth = 0.0f; // For Rectangle shape
+		float m_fHeight = 0.0f; // For Rectangle shape
+		int m_iLayers = 0; // A body without layers collides with nothing
+
+		void setCircle(float fRadius) {
+			m_eShape = Shape::Circle;
+			m_fRadius = fRadius;
+		}
+
+		void setRectangle(float fWidth, float fHeight) {
+			m_eShape = Shape::Rectangle;
+			m_fWidth = fWidth;
+			m_fHeight = fHeight;
+		}
+	};
+
+	// How two overlapping shapes touch, the normal points from A to B
+	struct Manifold {
+		sf::Vector2f m_vNormal;
+		float m_fDepth = 0.0f; // Distance A and B have to move apart along the normal
+	};
+
+	// A pair of bodies that touched during Step()
+	struct Contact {
+		BodyId m_BodyA;
+		BodyId m_BodyB;
+		Manifold m_Manifold;
+	};
+
+	PhysicsWorld();
+
+	BodyId CreateBody(const BodyDef& rDef, const sf::Vector2f& vPosition);
+	void DestroyBody(BodyId bodyId);
+	void Clear();
+
+	bool IsValid(BodyId bodyId) const {
+		return bodyId >= 0 && bodyId < (int)m_IdToIndex.size() && m_IdToIndex[bodyId] >= 0;
+	}
+
+	// Highest body id handed out so far plus one, for lookup tables indexed by body id
+	int GetBodyIdCount() const {
+		return (int)m_IdToIndex.size();
+	}
+
+	int GetBodyCount() const {
+		return (int)m_PositionX.size();
+	}
+
+	void Step(float fDeltaTime);
+
+	const std::vector<Contact>& GetContacts() const {
+		return m_Contacts;
+	}
+
+	sf::Vector2f GetPosition(BodyId bodyId) const {
+		const int i = m_IdToIndex[bodyId];
+		return sf::Vector2f(m_PositionX[i], m_PositionY[i]);
+	}
+
+	// Teleports the body, it will not be interpolated from its old position
+	void SetPosition(BodyId bodyId, const sf::Vector2f& vPosition) {
+		const int i = m_IdToIndex[bodyId];
+		if (m_Type[i] == Type::Static) {
+			m_bStaticBroadphaseDirty = true;
+		}
+		m_PositionX[i] = vPosition.x;
+		m_PositionY[i] = vPosition.y;
+		m_PreviousPositionX[i] = vPosition.x;
+		m_PreviousPositionY[i] = vPosition.y;
+	}
+
+	// Position between the last two steps, fAlpha = 0 is the previous step and 1 the latest
+	sf::Vector2f GetInterpolatedPosition(BodyId bodyId, float fAlpha) const {
+		const int i = m_IdToIndex[bodyId];
+		return sf::Vector2f(m_PreviousPositionX[i] + (m_PositionX[i] - m_PreviousPositionX[i]) * fAlpha,
+			m_PreviousPositionY[i] + (m_PositionY[i] - m_PreviousPositionY[i]) * fAlpha);
+	}
+
+	// Rotation is only visual, it never affects collisions
+	float GetRotation(BodyId bodyId) const {
+		return m_Rotation[m_IdToIndex[bodyId]];
+	}
+
+	void SetRotation(BodyId bodyId, float fDegrees) {
+		const int i = m_IdToIndex[bodyId];
+		m_Rotation[i] = fDegrees;
+		m_PreviousRotation[i] = fDegrees;
+	}
+
+	void SetAngularVelocity(BodyId bodyId, float fDegreesPerSecond) {
+		m_AngularVelocity[m_IdToIndex[bodyId]] = fDegreesPerSecond;
+	}
+
+	float GetInterpolatedRotation(BodyId bodyId, float fAlpha) const {
+		const int i = m_IdToIndex[bodyId];
+		return m_PreviousRotation[i] + (m_Rotation[i] - m_PreviousRotation[i]) * fAlpha;
+	}
+
+	sf::Vector2f GetVelocity(BodyId bodyId) const {
+		const int i = m_IdToIndex[bodyId];
+		return sf::Vector2f(m_VelocityX[i], m_VelocityY[i]);
+	}
+
+	void SetVelocity(BodyId bodyId, const sf::Vector2f& vVelocity) {
+		const int i = m_IdToIndex[bodyId];
+		m_VelocityX[i] = vVelocity.x;
+		m_VelocityY[i] = vVelocity.y;
+	}
+
+	void AddImpulse(BodyId bodyId, const sf::Vector2f& vImpulse) {
+		const int i = m_IdToIndex[bodyId];
+		m_ImpulseX[i] += vImpulse.x;
+		m_ImpulseY[i] += vImpulse.y;
+	}
+
+	bool IsInAnyLayer(BodyId bodyId, int iLayers) const {
+		return (m_Layers[m_IdToIndex[bodyId]] & iLayers) != 0;
+	}
+
+	sf::FloatRect GetBounds(BodyId bodyId) const {
+		return GetBoundsAtIndex(m_IdToIndex[bodyId]);
+	}
+
+	// Layer collision matrix, every layer collides with every layer by default.
+	// Takes layer masks, so several layers can be changed at once.
+	void SetLayersCollide(int iLayersA, int iLayersB, bool bCollide);
+
+	bool DoLayersCollide(int iLayersA, int iLayersB) const {
+		return (m_LayerGroupCollisionMask[iLayersA] & iLayersB) != 0;
+	}
+
+	void SetBruteForceBroadphase(bool bBruteForce) {
+		m_bBruteForceBroadphase = bBruteForce;
+	}
+
+	bool IsBruteForceBroadphase() const {
+		return m_bBruteForceBroadphase;
+	}
+
+	// Broadphase candidate gathering is split across the job system's threads, null runs it inline
+	void SetJobSystem(JobSystem* pJobSystem) {
+		m_pJobSystem = pJobSystem;
+	}
+
+	// Appends every static body in one of iLayers whose bounds overlap rBounds
+	void QueryStaticBodies(const sf::FloatRect& rBounds, int iLayers, std::vector<BodyId>& rOutBodies);
+
+	// Shape test for bodies that are not in the world, e.g. placement previews
+	static bool AreShapesOverlapping(const BodyDef& rDefA, const sf::Vector2f& vPositionA, const BodyDef& rDefB, const sf::Vector2f& vPositionB);
+
+private:
+	sf::FloatRect GetBoundsAtIndex(int i) const;
+	void RebuildLayerGroupCollisionMasks();
+	void RebuildStaticBroadphase();
+	struct CandidateChunk;
+	void GatherCandidates(int iBegin, int iEnd, CandidateChunk& rChunk) const;
+	void ResolveCandidates(int i, const int* pCandidates, int iCandidateCount);
+	// Builds the manifold of the pair once, records the contact and pushes the bodies apart
+	void ResolvePair(int iA, int iB);
+	void MoveBody(int i, const sf::Vector2f& vOffset) {
+		m_PositionX[i] += vOffset.x;
+		m_PositionY[i] += vOffset.y;
+	}
+
+	// Per body data, indexed by dense index
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	std::vector<float> m_PreviousPositionX; // Position before the last Step(), for render interpolation
+	std::vector<float> m_PreviousPositionY;
+	std::vector<float> m_Rotation;
+	std::vector<float> m_PreviousRotation;
+	std::vector<float> m_AngularVelocity;
+	std::vector<float> m_VelocityX;
+	std::vector<float> m_VelocityY;
+	std::vector<float> m_ImpulseX;
+	std::vector<float> m_ImpulseY;
+	std::vector<float> m_Radius;
+	std::vector<float> m_HalfWidth;
+	std::vector<float> m_HalfHeight;
+	std::vector<int> m_Layers;
+	std::vector<Shape> m_Shape;
+	std::vector<Type> m_Type;
+	std::vector<BodyId> m_IndexToId;
+
+	std::vector<int> m_IdToIndex; // -1 for free ids
+	std::vector<BodyId> m_FreeIds;
+
+	int m_LayerCollisionMask[LayerCount]; // Row of the collision matrix per layer bit
+	int m_LayerGroupCollisionMask[LayerGroupCount]; // Layers colliding with any layer of the group
+
+	// One grid per layer combination, a body only queries the grids it can collide with.
+	// Dynamic bodies are inserted by dense index every step. Static bodies never move, so
+	// their grids hold body ids and are only rebuilt after a static body was added, removed
+	// or teleported.
+	SpatialHashGrid m_LayerBroadphase[LayerGroupCount];
+	SpatialHashGrid m_StaticLayerBroadphase[LayerGroupCount];
+	bool m_bStaticBroadphaseDirty;
+	bool m_bBruteForceBroadphase; // Test every pair instead of using the grid, to compare results
+	JobSystem* m_pJobSystem;
+
+	// Filtered candidates of a contiguous range of dynamic bodies. Each range is gathered by one
+	// thread into its own chunk, then the chunks are resolved in order so results do not depend
+	// on how the work was split.
+	struct CandidateChunk {
+		std::vector<int> m_QueryResults; // Scratch for the grid queries
+		std::vector<int> m_StaticQueryResults;
+		std::vector<int> m_Bodies;
+		std::vector<int> m_CandidateEnds; // End of each body's candidates in m_Candidates
+		std::vector<int> m_Candidates;
+	};
+	static constexpr int BroadphaseGrainSize = 64;
+	std::vector<CandidateChunk> m_CandidateChunks;
+
+	// Candidates of the body being tested, gathered into flat arrays for CollisionKernels
+	struct CandidateBatch {
+		std::vector<int> m_Indices;
+		std::vector<float> m_X;
+		std::vector<float> m_Y;
+		std::vector<float> m_Radius;
+		std::vector<float> m_HalfWidth;
+		std::vector<float> m_HalfHeight;
+
+		void Clear() {
+			m_Indices.clear();
+			m_X.clear();
+			m_Y.clear();
+			m_Radius.clear();
+			m_HalfWidth.clear();
+			m_HalfHeight.clear();
+		}
+
+		void Add(int iIndex, float fX, float fY, float fRadius, float fHalfWidth, float fHalfHeight) {
+			m_Indices.push_back(iIndex);
+			m_X.push_back(fX);
+			m_Y.push_back(fY);
+			m_Radius.push_back(fRadius);
+			m_HalfWidth.push_back(fHalfWidth);
+			m_HalfHeight.push_back(fHalfHeight);
+		}
+	};
+	CandidateBatch m_CircleBatch;
+	CandidateBatch m_RectangleBatch;
+	std::vector<int> m_BatchHits;
+
+	std::vector<Contact> m_Contacts;
+};
@@ -0,0 +1,91 @@
+#include "RoutePolyline.h"
+#include "MathHelpers.h"
+#include <algorithm>
+#include <limits>
+
+void RoutePolyline::Clear() {
+	m_Points.clear();
+	m_Distances.clear();
+}
+
+void RoutePolyline::AddPoint(const sf::Vector2f& vPoint) {
+	if (m_Points.empty()) {
+		m_Points.push_back(vPoint);
+		m_Distances.push_back(0.0f);
+		return;
+	}
+
+	const sf::Vector2f vStep = vPoint - m_Points.back();
+	const float fStepLength = MathHelpers::flength(vStep);
+	if (fStepLength <= 0.0f) {
+		return;
+	}
+
+	const size_t uLast = m_Points.size() - 1;
+	if (uLast > 0) {
+		const sf::Vector2f vLastSegment = m_Points[uLast] - m_Points[uLast - 1];
+		const float fCross = vLastSegment.x * vStep.y - vLastSegment.y * vStep.x;
+		const float fDot = vLastSegment.x * vStep.x + vLastSegment.y * vStep.y;
+		if (fCross == 0.0f && fDot > 0.0f) {
+			m_Points[uLast] = vPoint;
+			m_Distances[uLast] += fStepLength;
+			return;
+		}
+	}
+
+	m_Points.push_back(vPoint);
+	m_Distances.push_back(m_Distances.back() + fStepLength);
+}
+
+void RoutePolyline::Seek(Cursor& rCursor, float fDistance) const {
+	const int iSegmentCount = GetSegmentCount();
+	if (iSegmentCount == 0) {
+		rCursor = Cursor();
+		return;
+	}
+
+	rCursor.m_fDistance = std::clamp(fDistance, 0.0f, GetLength());
+	int iSegment = std::clamp(rCursor.m_iSegment, 0, iSegmentCount - 1);
+	while (iSegment + 1 < iSegmentCount && rCursor.m_fDistance >= m_Distances[iSegment + 1]) {
+		iSegment++;
+	}
+	while (iSegment > 0 && rCursor.m_fDistance < m_Distances[iSegment]) {
+		iSegment--;
+	}
+	rCursor.m_iSegment = iSegment;
+}
+
+sf::Vector2f RoutePolyline::GetPoint(const Cursor& rCursor) const {
+	if (GetSegmentCount() == 0) {
+		return m_Points.empty() ? sf::Vector2f() : m_Points[0];
+	}
+	const int iSegment = rCursor.m_iSegment;
+	return m_Points[iSegment] + GetDirection(rCursor) * (rCursor.m_fDistance - m_Distances[iSegment]);
+}
+
+sf::Vector2f RoutePolyline::GetDirection(const Cursor& rCursor) const {
+	if (GetSegmentCount() == 0) {
+		return sf::Vector2f();
+	}
+	const int iSegment = rCursor.m_iSegment;
+	return (m_Points[iSegment + 1] - m_Points[iSegment]) / (m_Distances[iSegment + 1] - m_Distances[iSegment]);
+}
+
+RoutePolyline::Cursor RoutePolyline::Project(const sf::Vector2f& vPosition) const {
+	Cursor best;
+	float fBestDistanceSquared = std::numeric_limits<float>::max();
+	for (int iSegment = 0; iSegment < GetSegmentCount(); iSegment++) {
+		const float fSegmentLength = m_Distances[iSegment + 1] - m_Distances[iSegment];
+		const sf::Vector2f vDirection = (m_Points[iSegment + 1] - m_Points[iSegment]) / fSegmentLength;
+		const sf::Vector2f vToPosition = vPosition - m_Points[iSegment];
+		const float fAlong = std::clamp(vToPosition.x * vDirection.x + vToPosition.y * vDirection.y, 0.0f, fSegmentLength);
+		const sf::Vector2f vOffset = vToPosition - vDirection * fAlong;
+		const float fDistanceSquared = vOffset.x * vOffset.x + vOffset.y * vOffset.y;
+		if (fDistanceSquared < fBestDistanceSquared) {
+			fBestDistanceSquared = fDistanceSquared;
+			best.m_iSegment = iSegment;
+			best.m_fDistance = m_Distances[iSegment] + fAlong;
+		}
+	}
+	return best;
+}
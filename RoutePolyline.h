@@ -0,0 +1,43 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// A route baked into straight segments, with the distance from the start at every point.
+// Walkers keep a Cursor on it and move it by however far they walked, which only looks at the
+// segments it passes instead of searching the whole route.
+class RoutePolyline
+{
+public:
+	struct Cursor {
+		int m_iSegment = 0; // Segment the distance falls in, where seeking starts from
+		float m_fDistance = 0.0f;
+	};
+
+	void Clear();
+
+	// A point continuing the last segment in the same direction extends it instead of adding one
+	void AddPoint(const sf::Vector2f& vPoint);
+
+	float GetLength() const {
+		return m_Distances.empty() ? 0.0f : m_Distances.back();
+	}
+
+	int GetSegmentCount() const {
+		return m_Points.size() < 2 ? 0 : (int)m_Points.size() - 1;
+	}
+
+	// Moves rCursor to fDistance, clamped to the route, walking the segments from the one it is on
+	void Seek(Cursor& rCursor, float fDistance) const;
+
+	sf::Vector2f GetPoint(const Cursor& rCursor) const;
+
+	// Unit direction of the cursor's segment
+	sf::Vector2f GetDirection(const Cursor& rCursor) const;
+
+	// Cursor at the point of the route closest to vPosition, checks every segment
+	Cursor Project(const sf::Vector2f& vPosition) const;
+
+private:
+	std::vector<sf::Vector2f> m_Points;
+	std::vector<float> m_Distances; // From the start to each point
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// 32 bit reference to an item of a SlotMap: 20 bits of slot index and 12 bits of generation.
+// The generation changes whenever the slot is freed, so a handle to a removed item never
+// resolves to whatever reuses the slot later (until the generation wraps after 4096 reuses).
+class SlotHandle
+{
+public:
+	static constexpr uint32_t IndexBits = 20;
+	static constexpr uint32_t MaxIndex = (1u << IndexBits) - 1;
+	static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+	SlotHandle()
+		: m_uValue(0xFFFFFFFFu)
+	{
+	}
+
+	SlotHandle(uint32_t uIndex, uint32_t uGeneration)
+		: m_uValue((uGeneration & GenerationMask) << IndexBits | uIndex)
+	{
+		assert(uIndex < MaxIndex);
+	}
+
+	bool IsValid() const {
+		return m_uValue != 0xFFFFFFFFu;
+	}
+
+	uint32_t GetIndex() const {
+		return m_uValue & MaxIndex;
+	}
+
+	uint32_t GetGeneration() const {
+		return m_uValue >> IndexBits;
+	}
+
+	bool operator==(const SlotHandle& rOther) const {
+		return m_uValue == rOther.m_uValue;
+	}
+
+	bool operator!=(const SlotHandle& rOther) const {
+		return m_uValue != rOther.m_uValue;
+	}
+
+private:
+	uint32_t m_uValue;
+};
+
+// Items live packed in one array so iterating them is as cheap as iterating a vector.
+// Handles go through a slot table to find the packed index, removing an item moves the
+// last one into its place and patches that one slot, so removal is O(1) and every other
+// handle stays valid. Plain indices (operator[], RemoveAt) are only stable until the next removal.
+template <typename T>
+class SlotMap
+{
+public:
+	typedef SlotHandle Handle;
+	typedef typename std::vector<T>::iterator iterator;
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+	Handle Insert(const T& rItem) {
+		uint32_t uSlot;
+		if (!m_FreeSlots.empty()) {
+			uSlot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else {
+			uSlot = (uint32_t)m_Slots.size();
+			m_Slots.push_back(Slot());
+		}
+
+		m_Slots[uSlot].m_iItemIndex = (int)m_Items.size();
+		m_Items.push_back(rItem);
+		m_ItemSlots.push_back(uSlot);
+		return Handle(uSlot, m_Slots[uSlot].m_uGeneration);
+	}
+
+	bool Remove(Handle handle) {
+		if (!Contains(handle)) {
+			return false;
+		}
+		RemoveAt(m_Slots[handle.GetIndex()].m_iItemIndex);
+		return true;
+	}
+
+	void RemoveAt(int iIndex) {
+		assert(iIndex >= 0 && iIndex < size());
+		const uint32_t uSlot = m_ItemSlots[iIndex];
+
+		// Move the last item into the hole and point its slot at the new place
+		if (iIndex != size() - 1) {
+			m_Items[iIndex] = std::move(m_Items.back());
+			m_ItemSlots[iIndex] = m_ItemSlots.back();
+			m_Slots[m_ItemSlots[iIndex]].m_iItemIndex = iIndex;
+		}
+		m_Items.pop_back();
+		m_ItemSlots.pop_back();
+
+		m_Slots[uSlot].m_iItemIndex = -1;
+		m_Slots[uSlot].m_uGeneration = (m_Slots[uSlot].m_uGeneration + 1) & SlotHandle::GenerationMask;
+		m_FreeSlots.push_back(uSlot);
+	}
+
+	bool Contains(Handle handle) const {
+		if (!handle.IsValid() || handle.GetIndex() >= m_Slots.size()) {
+			return false;
+		}
+		const Slot& rSlot = m_Slots[handle.GetIndex()];
+		return rSlot.m_iItemIndex >= 0 && rSlot.m_uGeneration == handle.GetGeneration();
+	}
+
+	// nullptr if the item was removed
+	T* Get(Handle handle) {
+		return Contains(handle) ? &m_Items[m_Slots[handle.GetIndex()].m_iItemIndex] : nullptr;
+	}
+
+	const T* Get(Handle handle) const {
+		return Contains(handle) ? &m_Items[m_Slots[handle.GetIndex()].m_iItemIndex] : nullptr;
+	}
+
+	Handle GetHandleAt(int iIndex) const {
+		const uint32_t uSlot = m_ItemSlots[iIndex];
+		return Handle(uSlot, m_Slots[uSlot].m_uGeneration);
+	}
+
+	// Grows every buffer up front, Insert() does not allocate until iCapacity items are live
+	void Reserve(int iCapacity) {
+		m_Items.reserve(iCapacity);
+		m_ItemSlots.reserve(iCapacity);
+		m_Slots.reserve(iCapacity);
+		m_FreeSlots.reserve(iCapacity);
+	}
+
+	void clear() {
+		// Removing one by one bumps every generation, so no old handle survives the clear
+		while (!m_Items.empty()) {
+			RemoveAt(size() - 1);
+		}
+	}
+
+	int size() const {
+		return (int)m_Items.size();
+	}
+
+	bool empty() const {
+		return m_Items.empty();
+	}
+
+	T& operator[](int iIndex) {
+		return m_Items[iIndex];
+	}
+
+	const T& operator[](int iIndex) const {
+		return m_Items[iIndex];
+	}
+
+	iterator begin() {
+		return m_Items.begin();
+	}
+
+	iterator end() {
+		return m_Items.end();
+	}
+
+	const_iterator begin() const {
+		return m_Items.begin();
+	}
+
+	const_iterator end() const {
+		return m_Items.end();
+	}
+
+private:
+	struct Slot {
+		int m_iItemIndex = -1; // -1 while the slot is free
+		uint32_t m_uGeneration = 0;
+	};
+
+	std::vector<T> m_Items;
+	std::vector<uint32_t> m_ItemSlots; // Slot of each item, parallel to m_Items
+	std::vector<Slot> m_Slots;
+	std::vector<uint32_t> m_FreeSlots;
+};
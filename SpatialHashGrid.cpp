@@ -0,0 +1,100 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+
+SpatialHashGrid::SpatialHashGrid(float fCellSize)
+	: m_fCellSize(fCellSize)
+	, m_uBucketMask(0)
+{
+	m_BucketStart.assign(2, 0);
+}
+
+void SpatialHashGrid::SetCellSize(float fCellSize) {
+	m_fCellSize = fCellSize;
+	Clear();
+}
+
+void SpatialHashGrid::Clear() {
+	m_PendingEntries.clear();
+	m_Entries.clear();
+	m_uBucketMask = 0;
+	m_BucketStart.assign(2, 0);
+}
+
+void SpatialHashGrid::Insert(int iId, const sf::FloatRect& rBounds) {
+	if (iId >= (int)m_Bounds.size()) {
+		m_Bounds.resize(iId + 1);
+	}
+	m_Bounds[iId] = rBounds;
+
+	const int iMinX = GetCellCoordinate(rBounds.left);
+	const int iMinY = GetCellCoordinate(rBounds.top);
+	const int iMaxX = GetCellCoordinate(rBounds.left + rBounds.width);
+	const int iMaxY = GetCellCoordinate(rBounds.top + rBounds.height);
+
+	for (int y = iMinY; y <= iMaxY; y++) {
+		for (int x = iMinX; x <= iMaxX; x++) {
+			m_PendingEntries.push_back({ iId, x, y });
+		}
+	}
+}
+
+void SpatialHashGrid::Build() {
+	// Keep the table at least twice as large as the number of entries to keep chains short
+	unsigned uBucketCount = 64;
+	while (uBucketCount < m_PendingEntries.size() * 2) {
+		uBucketCount *= 2;
+	}
+	m_uBucketMask = uBucketCount - 1;
+
+	m_BucketStart.assign(uBucketCount + 1, 0);
+	for (const Entry& rEntry : m_PendingEntries) {
+		m_BucketStart[GetBucketIndex(rEntry.iCellX, rEntry.iCellY) + 1]++;
+	}
+	for (unsigned i = 0; i < uBucketCount; i++) {
+		m_BucketStart[i + 1] += m_BucketStart[i];
+	}
+
+	m_Entries.resize(m_PendingEntries.size());
+	// Scatter using the bucket start as a write cursor, then shift it back
+	for (const Entry& rEntry : m_PendingEntries) {
+		m_Entries[m_BucketStart[GetBucketIndex(rEntry.iCellX, rEntry.iCellY)]++] = rEntry;
+	}
+	for (unsigned i = uBucketCount; i > 0; i--) {
+		m_BucketStart[i] = m_BucketStart[i - 1];
+	}
+	m_BucketStart[0] = 0;
+
+	m_PendingEntries.clear();
+}
+
+void SpatialHashGrid::Query(const sf::FloatRect& rBounds, std::vector<int>& rOutIds) const {
+	if (m_Entries.empty()) {
+		return;
+	}
+
+	const int iMinX = GetCellCoordinate(rBounds.left);
+	const int iMinY = GetCellCoordinate(rBounds.top);
+	const int iMaxX = GetCellCoordinate(rBounds.left + rBounds.width);
+	const int iMaxY = GetCellCoordinate(rBounds.top + rBounds.height);
+
+	for (int y = iMinY; y <= iMaxY; y++) {
+		for (int x = iMinX; x <= iMaxX; x++) {
+			const unsigned uBucket = GetBucketIndex(x, y);
+			for (int i = m_BucketStart[uBucket]; i < m_BucketStart[uBucket + 1]; i++) {
+				const Entry& rEntry = m_Entries[i];
+				if (rEntry.iCellX != x || rEntry.iCellY != y) continue; // Hash collision with another cell
+
+				const sf::FloatRect& rOtherBounds = m_Bounds[rEntry.iId];
+				if (!rOtherBounds.intersects(rBounds)) continue;
+
+				// Two overlapping boxes share many cells, only report the pair from the cell
+				// holding the top left corner of their intersection
+				const int iReferenceX = GetCellCoordinate(std::max(rBounds.left, rOtherBounds.left));
+				const int iReferenceY = GetCellCoordinate(std::max(rBounds.top, rOtherBounds.top));
+				if (iReferenceX != x || iReferenceY != y) continue;
+
+				rOutIds.push_back(rEntry.iId);
+			}
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cmath>
+
+// Uniform grid broadphase. Every id is inserted into each cell its bounds overlap,
+// cells are hashed into a power-of-two bucket table and the table is rebuilt with a
+// counting sort, so once the buffers have grown no allocation happens per tick.
+class SpatialHashGrid
+{
+public:
+	SpatialHashGrid(float fCellSize = 160.0f);
+
+	void SetCellSize(float fCellSize);
+	float GetCellSize() const {
+		return m_fCellSize;
+	}
+
+	void Clear();
+	void Insert(int iId, const sf::FloatRect& rBounds);
+	void Build();
+
+	// Appends every inserted id whose bounds overlap rBounds, each id only once.
+	// Safe to call from several threads at the same time once Build() returned.
+	void Query(const sf::FloatRect& rBounds, std::vector<int>& rOutIds) const;
+
+	int GetEntryCount() const {
+		return (int)m_Entries.size();
+	}
+
+private:
+	struct Entry {
+		int iId;
+		int iCellX;
+		int iCellY;
+	};
+
+	int GetCellCoordinate(float fValue) const {
+		return (int)std::floor(fValue / m_fCellSize);
+	}
+
+	unsigned GetBucketIndex(int iCellX, int iCellY) const {
+		const unsigned uHash = (unsigned)iCellX * 73856093u ^ (unsigned)iCellY * 19349663u;
+		return uHash & m_uBucketMask;
+	}
+
+	float m_fCellSize;
+	unsigned m_uBucketMask;
+
+	std::vector<sf::FloatRect> m_Bounds; // Indexed by id
+	std::vector<Entry> m_PendingEntries;
+	std::vector<Entry> m_Entries; // Sorted by bucket after Build()
+	std::vector<int> m_BucketStart;
+};
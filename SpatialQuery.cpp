@@ -0,0 +1,218 @@
+#include "SpatialQuery.h"
+#include <algorithm>
+#include <limits>
+
+SpatialQuery::SpatialQuery(float fCellSize)
+	: m_fCellSize(fCellSize)
+	, m_uBucketMask(0)
+	, m_iMinCellX(0)
+	, m_iMinCellY(0)
+	, m_iMaxCellX(-1)
+	, m_iMaxCellY(-1)
+{
+	m_BucketStart.assign(2, 0);
+}
+
+void SpatialQuery::SetCellSize(float fCellSize) {
+	m_fCellSize = fCellSize;
+	Clear();
+}
+
+void SpatialQuery::Clear() {
+	m_PendingEntries.clear();
+	m_Entries.clear();
+	m_uBucketMask = 0;
+	m_BucketStart.assign(2, 0);
+	m_iMinCellX = 0;
+	m_iMinCellY = 0;
+	m_iMaxCellX = -1;
+	m_iMaxCellY = -1;
+}
+
+void SpatialQuery::Insert(int iId, const sf::Vector2f& vPosition, int iLayers) {
+	if (iId >= (int)m_Points.size()) {
+		m_Points.resize(iId + 1);
+	}
+	m_Points[iId] = { vPosition, iLayers };
+	m_PendingEntries.push_back({ iId, GetCellCoordinate(vPosition.x), GetCellCoordinate(vPosition.y) });
+}
+
+void SpatialQuery::Build() {
+	unsigned uBucketCount = 64;
+	while (uBucketCount < m_PendingEntries.size() * 2) {
+		uBucketCount *= 2;
+	}
+	m_uBucketMask = uBucketCount - 1;
+
+	m_iMinCellX = std::numeric_limits<int>::max();
+	m_iMinCellY = std::numeric_limits<int>::max();
+	m_iMaxCellX = std::numeric_limits<int>::min();
+	m_iMaxCellY = std::numeric_limits<int>::min();
+
+	m_BucketStart.assign(uBucketCount + 1, 0);
+	for (const Entry& rEntry : m_PendingEntries) {
+		m_BucketStart[GetBucketIndex(rEntry.iCellX, rEntry.iCellY) + 1]++;
+		m_iMinCellX = std::min(m_iMinCellX, rEntry.iCellX);
+		m_iMinCellY = std::min(m_iMinCellY, rEntry.iCellY);
+		m_iMaxCellX = std::max(m_iMaxCellX, rEntry.iCellX);
+		m_iMaxCellY = std::max(m_iMaxCellY, rEntry.iCellY);
+	}
+	for (unsigned i = 0; i < uBucketCount; i++) {
+		m_BucketStart[i + 1] += m_BucketStart[i];
+	}
+
+	m_Entries.resize(m_PendingEntries.size());
+	// Scatter using the bucket start as a write cursor, then shift it back
+	for (const Entry& rEntry : m_PendingEntries) {
+		m_Entries[m_BucketStart[GetBucketIndex(rEntry.iCellX, rEntry.iCellY)]++] = rEntry;
+	}
+	for (unsigned i = uBucketCount; i > 0; i--) {
+		m_BucketStart[i] = m_BucketStart[i - 1];
+	}
+	m_BucketStart[0] = 0;
+
+	m_PendingEntries.clear();
+}
+
+template <typename Visitor>
+void SpatialQuery::VisitCell(int iCellX, int iCellY, const sf::Vector2f& vPosition, int iLayers, Visitor& rVisitor) const {
+	if (iCellX < m_iMinCellX || iCellX > m_iMaxCellX || iCellY < m_iMinCellY || iCellY > m_iMaxCellY) {
+		return;
+	}
+
+	const unsigned uBucket = GetBucketIndex(iCellX, iCellY);
+	for (int i = m_BucketStart[uBucket]; i < m_BucketStart[uBucket + 1]; i++) {
+		const Entry& rEntry = m_Entries[i];
+		if (rEntry.iCellX != iCellX || rEntry.iCellY != iCellY) continue; // Hash collision with another cell
+		if ((m_Points[rEntry.iId].iLayers & iLayers) == 0) continue;
+
+		rVisitor(rEntry.iId, GetDistanceSquared(rEntry.iId, vPosition));
+	}
+}
+
+template <typename Visitor>
+bool SpatialQuery::VisitRing(int iCellX, int iCellY, int iRing, const sf::Vector2f& vPosition, int iLayers, Visitor& rVisitor) const {
+	// Every occupied cell is closer than this ring, the search is done
+	const int iLastRing = std::max(std::max(iCellX - m_iMinCellX, m_iMaxCellX - iCellX), std::max(iCellY - m_iMinCellY, m_iMaxCellY - iCellY));
+	if (iRing > iLastRing) {
+		return false;
+	}
+
+	if (iRing == 0) {
+		VisitCell(iCellX, iCellY, vPosition, iLayers, rVisitor);
+		return true;
+	}
+
+	// Top and bottom rows, then the columns in between, clipped to the occupied cells
+	const int iMinX = std::max(iCellX - iRing, m_iMinCellX);
+	const int iMaxX = std::min(iCellX + iRing, m_iMaxCellX);
+	const int iMinY = std::max(iCellY - iRing + 1, m_iMinCellY);
+	const int iMaxY = std::min(iCellY + iRing - 1, m_iMaxCellY);
+	for (int x = iMinX; x <= iMaxX; x++) {
+		VisitCell(x, iCellY - iRing, vPosition, iLayers, rVisitor);
+		VisitCell(x, iCellY + iRing, vPosition, iLayers, rVisitor);
+	}
+	for (int y = iMinY; y <= iMaxY; y++) {
+		VisitCell(iCellX - iRing, y, vPosition, iLayers, rVisitor);
+		VisitCell(iCellX + iRing, y, vPosition, iLayers, rVisitor);
+	}
+	return true;
+}
+
+int SpatialQuery::QueryNearest(const sf::Vector2f& vPosition, float fMaxRange, int iLayers) const {
+	if (m_Entries.empty()) {
+		return -1;
+	}
+
+	int iNearest = -1;
+	float fNearestDistanceSquared = fMaxRange * fMaxRange;
+	auto visitor = [&](int iId, float fDistanceSquared) {
+		// Ties go to the lower id so the result does not depend on the bucket order
+		if (fDistanceSquared < fNearestDistanceSquared || (fDistanceSquared == fNearestDistanceSquared && (iNearest < 0 || iId < iNearest))) {
+			fNearestDistanceSquared = fDistanceSquared;
+			iNearest = iId;
+		}
+	};
+
+	const int iCellX = GetCellCoordinate(vPosition.x);
+	const int iCellY = GetCellCoordinate(vPosition.y);
+	for (int iRing = 0; ; iRing++) {
+		const float fRingDistance = GetRingDistance(iRing);
+		if (fRingDistance * fRingDistance > fNearestDistanceSquared) {
+			break; // Nothing further out can be closer or in range
+		}
+		if (!VisitRing(iCellX, iCellY, iRing, vPosition, iLayers, visitor)) {
+			break;
+		}
+	}
+	return iNearest;
+}
+
+void SpatialQuery::QueryKNearest(const sf::Vector2f& vPosition, int iCount, float fMaxRange, int iLayers, std::vector<int>& rOutIds) const {
+	rOutIds.clear();
+	if (m_Entries.empty() || iCount <= 0) {
+		return;
+	}
+
+	// rOutIds stays sorted by distance, once it is full only closer points get in
+	const float fMaxRangeSquared = fMaxRange * fMaxRange;
+	auto visitor = [&](int iId, float fDistanceSquared) {
+		if (fDistanceSquared > fMaxRangeSquared) {
+			return;
+		}
+		auto IsCloser = [&](int iOtherId) {
+			const float fOtherDistanceSquared = GetDistanceSquared(iOtherId, vPosition);
+			return fDistanceSquared < fOtherDistanceSquared || (fDistanceSquared == fOtherDistanceSquared && iId < iOtherId);
+		};
+		if ((int)rOutIds.size() == iCount) {
+			if (!IsCloser(rOutIds.back())) {
+				return;
+			}
+			rOutIds.pop_back();
+		}
+
+		int iInsert = (int)rOutIds.size();
+		while (iInsert > 0 && IsCloser(rOutIds[iInsert - 1])) {
+			iInsert--;
+		}
+		rOutIds.insert(rOutIds.begin() + iInsert, iId);
+	};
+
+	const int iCellX = GetCellCoordinate(vPosition.x);
+	const int iCellY = GetCellCoordinate(vPosition.y);
+	for (int iRing = 0; ; iRing++) {
+		const float fRingDistance = GetRingDistance(iRing);
+		if (fRingDistance * fRingDistance > fMaxRangeSquared) {
+			break;
+		}
+		if ((int)rOutIds.size() == iCount && fRingDistance * fRingDistance > GetDistanceSquared(rOutIds.back(), vPosition)) {
+			break; // Full and nothing further out can be closer
+		}
+		if (!VisitRing(iCellX, iCellY, iRing, vPosition, iLayers, visitor)) {
+			break;
+		}
+	}
+}
+
+void SpatialQuery::QueryInRadius(const sf::Vector2f& vPosition, float fRadius, int iLayers, std::vector<int>& rOutIds) const {
+	if (m_Entries.empty()) {
+		return;
+	}
+
+	const float fRadiusSquared = fRadius * fRadius;
+	auto visitor = [&](int iId, float fDistanceSquared) {
+		if (fDistanceSquared <= fRadiusSquared) {
+			rOutIds.push_back(iId);
+		}
+	};
+
+	const int iMinX = std::max(m_iMinCellX, GetCellCoordinate(vPosition.x - fRadius));
+	const int iMinY = std::max(m_iMinCellY, GetCellCoordinate(vPosition.y - fRadius));
+	const int iMaxX = std::min(m_iMaxCellX, GetCellCoordinate(vPosition.x + fRadius));
+	const int iMaxY = std::min(m_iMaxCellY, GetCellCoordinate(vPosition.y + fRadius));
+	for (int y = iMinY; y <= iMaxY; y++) {
+		for (int x = iMinX; x <= iMaxX; x++) {
+			VisitCell(x, y, vPosition, iLayers, visitor);
+		}
+	}
+}
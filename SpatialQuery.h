@@ -0,0 +1,90 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cmath>
+
+// Nearest neighbour and radius queries over points, e.g. towers looking for enemies.
+// Points are bucketed into a hashed uniform grid the same way SpatialHashGrid does it, and
+// searches walk outwards ring by ring from the query cell until no closer point can exist.
+// Rebuild it once per tick, queries are const and safe to run from several threads.
+class SpatialQuery
+{
+public:
+	SpatialQuery(float fCellSize = 160.0f);
+
+	void SetCellSize(float fCellSize);
+	float GetCellSize() const {
+		return m_fCellSize;
+	}
+
+	void Clear();
+	// iId must be >= 0, iLayers is matched against the layer mask of the queries
+	void Insert(int iId, const sf::Vector2f& vPosition, int iLayers);
+	void Build();
+
+	// Closest point in one of iLayers at most fMaxRange away, -1 if there is none
+	int QueryNearest(const sf::Vector2f& vPosition, float fMaxRange, int iLayers) const;
+
+	// Replaces rOutIds with up to iCount points at most fMaxRange away, closest first
+	void QueryKNearest(const sf::Vector2f& vPosition, int iCount, float fMaxRange, int iLayers, std::vector<int>& rOutIds) const;
+
+	// Appends every point in one of iLayers at most fRadius away
+	void QueryInRadius(const sf::Vector2f& vPosition, float fRadius, int iLayers, std::vector<int>& rOutIds) const;
+
+	int GetPointCount() const {
+		return (int)m_Entries.size();
+	}
+
+private:
+	struct Point {
+		sf::Vector2f vPosition;
+		int iLayers;
+	};
+
+	struct Entry {
+		int iId;
+		int iCellX;
+		int iCellY;
+	};
+
+	int GetCellCoordinate(float fValue) const {
+		return (int)std::floor(fValue / m_fCellSize);
+	}
+
+	unsigned GetBucketIndex(int iCellX, int iCellY) const {
+		const unsigned uHash = (unsigned)iCellX * 73856093u ^ (unsigned)iCellY * 19349663u;
+		return uHash & m_uBucketMask;
+	}
+
+	float GetDistanceSquared(int iId, const sf::Vector2f& vPosition) const {
+		const sf::Vector2f vDelta = m_Points[iId].vPosition - vPosition;
+		return vDelta.x * vDelta.x + vDelta.y * vDelta.y;
+	}
+
+	// Calls rVisitor(iId, fDistanceSquared) for the points of iLayers in the cells at Chebyshev distance
+	// iRing from the query cell. Returns false once the ring lies beyond every occupied cell.
+	template <typename Visitor>
+	bool VisitRing(int iCellX, int iCellY, int iRing, const sf::Vector2f& vPosition, int iLayers, Visitor& rVisitor) const;
+
+	template <typename Visitor>
+	void VisitCell(int iCellX, int iCellY, const sf::Vector2f& vPosition, int iLayers, Visitor& rVisitor) const;
+
+	// Smallest distance a point of ring iRing can have from any position inside the query cell
+	float GetRingDistance(int iRing) const {
+		return iRing > 0 ? (iRing - 1) * m_fCellSize : 0.0f;
+	}
+
+	float m_fCellSize;
+	unsigned m_uBucketMask;
+
+	// Cells that hold at least one point, rings outside of them are skipped
+	int m_iMinCellX;
+	int m_iMinCellY;
+	int m_iMaxCellX;
+	int m_iMaxCellY;
+
+	std::vector<Point> m_Points; // Indexed by id
+	std::vector<Entry> m_PendingEntries;
+	std::vector<Entry> m_Entries; // Sorted by bucket after Build()
+	std::vector<int> m_BucketStart;
+};
@@ -0,0 +1,109 @@
+#include "SpriteBatch.h"
+#include <algorithm>
+
+void SpriteBatch::Begin() {
+	for (Batch& rBatch : m_Batches) {
+		rBatch.m_Vertices.clear();
+	}
+	m_iBatchesStarted = 0;
+}
+
+void SpriteBatch::Add(const sf::Sprite& rSprite, int iLayer) {
+	AddQuad(rSprite, rSprite.getTransform(), iLayer);
+}
+
+void SpriteBatch::Add(const sf::Sprite& rSprite, const sf::Vector2f& vPosition, float fRotation, int iLayer) {
+	// Same order sf::Transformable uses: origin, scale, rotation, position
+	sf::Transform transform;
+	transform.translate(vPosition);
+	transform.rotate(fRotation);
+	transform.scale(rSprite.getScale().x, rSprite.getScale().y);
+	transform.translate(-rSprite.getOrigin());
+	AddQuad(rSprite, transform, iLayer);
+}
+
+void SpriteBatch::AddQuad(const sf::Sprite& rSprite, const sf::Transform& rTransform, int iLayer) {
+	const sf::IntRect& rRect = rSprite.getTextureRect();
+	const float fWidth = (float)std::abs(rRect.width);
+	const float fHeight = (float)std::abs(rRect.height);
+	const float fLeft = (float)rRect.left;
+	const float fTop = (float)rRect.top;
+	const float fRight = (float)(rRect.left + rRect.width);
+	const float fBottom = (float)(rRect.top + rRect.height);
+	const sf::Color& rColor = rSprite.getColor();
+
+	const sf::Vertex topLeft(rTransform.transformPoint(0.0f, 0.0f), rColor, sf::Vector2f(fLeft, fTop));
+	const sf::Vertex topRight(rTransform.transformPoint(fWidth, 0.0f), rColor, sf::Vector2f(fRight, fTop));
+	const sf::Vertex bottomRight(rTransform.transformPoint(fWidth, fHeight), rColor, sf::Vector2f(fRight, fBottom));
+	const sf::Vertex bottomLeft(rTransform.transformPoint(0.0f, fHeight), rColor, sf::Vector2f(fLeft, fBottom));
+
+	// Two triangles, quads are deprecated
+	sf::VertexArray& rVertices = GetBatch(rSprite.getTexture(), iLayer).m_Vertices;
+	rVertices.append(topLeft);
+	rVertices.append(topRight);
+	rVertices.append(bottomRight);
+	rVertices.append(topLeft);
+	rVertices.append(bottomRight);
+	rVertices.append(bottomLeft);
+}
+
+SpriteBatch::Batch& SpriteBatch::GetBatch(const sf::Texture* pTexture, int iLayer) {
+	// A frame only has a handful of textures and layers, a linear search beats a map
+	Batch* pEmpty = nullptr;
+	for (Batch& rBatch : m_Batches) {
+		if (rBatch.m_Vertices.getVertexCount() == 0) {
+			if (!pEmpty) pEmpty = &rBatch;
+			continue;
+		}
+		if (rBatch.m_pTexture == pTexture && rBatch.m_iLayer == iLayer) {
+			return rBatch;
+		}
+	}
+
+	Batch& rBatch = pEmpty ? *pEmpty : m_Batches.emplace_back();
+	rBatch.m_pTexture = pTexture;
+	rBatch.m_iLayer = iLayer;
+	rBatch.m_iFirstUse = m_iBatchesStarted++;
+	return rBatch;
+}
+
+void SpriteBatch::Draw(sf::RenderTarget& rTarget, sf::RenderStates states) {
+	m_DrawOrder.clear();
+	for (Batch& rBatch : m_Batches) {
+		if (rBatch.m_Vertices.getVertexCount() > 0) {
+			m_DrawOrder.push_back(&rBatch);
+		}
+	}
+	std::sort(m_DrawOrder.begin(), m_DrawOrder.end(), [](const Batch* pA, const Batch* pB) {
+		return pA->m_iLayer != pB->m_iLayer ? pA->m_iLayer < pB->m_iLayer : pA->m_iFirstUse < pB->m_iFirstUse;
+		});
+
+	m_Stats = Stats();
+	for (size_t uFirst = 0; uFirst < m_DrawOrder.size();) {
+		const sf::Texture* pTexture = m_DrawOrder[uFirst]->m_pTexture;
+		size_t uEnd = uFirst + 1;
+		while (uEnd < m_DrawOrder.size() && m_DrawOrder[uEnd]->m_pTexture == pTexture) {
+			uEnd++;
+		}
+
+		// A run of layers on the same texture is copied into one array, bottom layer first
+		const sf::VertexArray* pVertices = &m_DrawOrder[uFirst]->m_Vertices;
+		if (uEnd - uFirst > 1) {
+			m_MergedVertices.clear();
+			for (size_t uBatch = uFirst; uBatch < uEnd; uBatch++) {
+				const sf::VertexArray& rVertices = m_DrawOrder[uBatch]->m_Vertices;
+				for (size_t uVertex = 0; uVertex < rVertices.getVertexCount(); uVertex++) {
+					m_MergedVertices.append(rVertices[uVertex]);
+				}
+			}
+			pVertices = &m_MergedVertices;
+		}
+
+		states.texture = pTexture;
+		rTarget.draw(*pVertices, states);
+		m_Stats.m_iDrawCalls++;
+		m_Stats.m_iVertices += (int)pVertices->getVertexCount();
+		uFirst = uEnd;
+	}
+	m_Stats.m_iSprites = m_Stats.m_iVertices / 6;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// Collects sprites as textured quads and draws them with one draw call per texture and layer,
+// instead of one per sprite. Lower layers are drawn first, inside a layer the batches keep the
+// order their textures were first added in. Batches that end up next to each other with the same
+// texture share a draw call, so sprites from one atlas are drawn at once whatever their layer.
+// Vertex storage is kept between frames.
+class SpriteBatch
+{
+public:
+	struct Stats {
+		int m_iDrawCalls = 0;
+		int m_iVertices = 0;
+		int m_iSprites = 0;
+	};
+
+	// Drops the sprites of the last frame
+	void Begin();
+
+	void Add(const sf::Sprite& rSprite, int iLayer);
+
+	// rSprite's texture, texture rect, colour, scale and origin at another position and rotation,
+	// so shared sprites do not need to be copied to be moved
+	void Add(const sf::Sprite& rSprite, const sf::Vector2f& vPosition, float fRotation, int iLayer);
+
+	void Draw(sf::RenderTarget& rTarget, sf::RenderStates states = sf::RenderStates::Default);
+
+	// Counts of the last Draw()
+	const Stats& GetStats() const {
+		return m_Stats;
+	}
+
+private:
+	struct Batch {
+		const sf::Texture* m_pTexture = nullptr;
+		int m_iLayer = 0;
+		int m_iFirstUse = 0; // Keeps batches of a layer in the order they were started
+		sf::VertexArray m_Vertices = sf::VertexArray(sf::Triangles);
+	};
+
+	void AddQuad(const sf::Sprite& rSprite, const sf::Transform& rTransform, int iLayer);
+	Batch& GetBatch(const sf::Texture* pTexture, int iLayer);
+
+	std::vector<Batch> m_Batches; // Empty ones are reused next frame
+	std::vector<Batch*> m_DrawOrder;
+	sf::VertexArray m_MergedVertices = sf::VertexArray(sf::Triangles);
+	int m_iBatchesStarted = 0;
+	Stats m_Stats;
+};
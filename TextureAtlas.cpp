@@ -0,0 +1,162 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+	// Transparent pixels around every image, sprites drawn rotated or scaled sample a little past their rect
+	constexpr unsigned int Padding = 1;
+}
+
+int TextureAtlas::AddDirectory(const std::string& directoryPath) {
+	std::error_code error;
+	std::filesystem::directory_iterator directory(directoryPath, error);
+	if (error) {
+		std::cout << "Cannot read image directory " << directoryPath << std::endl;
+		return 0;
+	}
+
+	int iAdded = 0;
+	for (const std::filesystem::directory_entry& entry : directory) {
+		if (entry.is_regular_file() && GetKey(entry.path().extension().string()) == ".png") {
+			iAdded += AddImage(entry.path().filename().string(), entry.path().string()) ? 1 : 0;
+		}
+	}
+	return iAdded;
+}
+
+bool TextureAtlas::AddImage(const std::string& name, const std::string& filePath) {
+	PendingImage pendingImage;
+	if (!pendingImage.m_Image.loadFromFile(filePath)) {
+		return false;
+	}
+	pendingImage.m_Name = GetKey(name);
+	m_PendingImages.push_back(std::move(pendingImage));
+	return true;
+}
+
+bool TextureAtlas::Build(unsigned int uMaxPageSize) {
+	uMaxPageSize = std::min(uMaxPageSize, sf::Texture::getMaximumSize());
+
+	std::vector<PendingImage*> remaining;
+	for (PendingImage& rImage : m_PendingImages) {
+		remaining.push_back(&rImage);
+	}
+	std::sort(remaining.begin(), remaining.end(), [](const PendingImage* pA, const PendingImage* pB) {
+		return pA->m_Image.getSize().y > pB->m_Image.getSize().y;
+		});
+
+	bool bPackedAll = true;
+	std::vector<PendingImage*> placed;
+	std::vector<PendingImage*> leftOver;
+	while (!remaining.empty()) {
+		// Start at the smallest page that could hold the rest and grow it until they fit
+		size_t uArea = 0;
+		for (const PendingImage* pImage : remaining) {
+			uArea += (size_t)(pImage->m_Image.getSize().x + Padding * 2) * (pImage->m_Image.getSize().y + Padding * 2);
+		}
+		// Width and height double in turn, a page does not have to be square
+		sf::Vector2u vPageSize(64, 64);
+		const auto Grow = [&]() {
+			unsigned int& rSide = vPageSize.x > vPageSize.y ? vPageSize.y : vPageSize.x;
+			rSide = std::min(rSide * 2, uMaxPageSize);
+		};
+		while (vPageSize.y < uMaxPageSize && (size_t)vPageSize.x * vPageSize.y < uArea) {
+			Grow();
+		}
+		for (;;) {
+			placed = remaining;
+			PackPage(vPageSize, placed, leftOver);
+			if (leftOver.empty() || vPageSize.y >= uMaxPageSize) break;
+			Grow();
+		}
+
+		if (placed.empty()) {
+			for (const PendingImage* pImage : leftOver) {
+				std::cout << "Image " << pImage->m_Name << " does not fit on a " << uMaxPageSize << " pixel atlas page" << std::endl;
+			}
+			bPackedAll = false;
+			break;
+		}
+
+		sf::Image page;
+		page.create(vPageSize.x, vPageSize.y, sf::Color::Transparent);
+		for (const PendingImage* pImage : placed) {
+			page.copy(pImage->m_Image, pImage->m_vPosition.x, pImage->m_vPosition.y);
+		}
+		sf::Texture& rTexture = *m_Pages.emplace_back(std::make_unique<sf::Texture>());
+		if (!rTexture.loadFromImage(page)) {
+			bPackedAll = false;
+			break;
+		}
+		for (const PendingImage* pImage : placed) {
+			const sf::Vector2u vSize = pImage->m_Image.getSize();
+			m_Regions[pImage->m_Name] = { &rTexture, sf::IntRect((int)pImage->m_vPosition.x, (int)pImage->m_vPosition.y, (int)vSize.x, (int)vSize.y) };
+		}
+		remaining.swap(leftOver);
+	}
+
+	m_PendingImages.clear();
+	return bPackedAll;
+}
+
+void TextureAtlas::PackPage(const sf::Vector2u& vPageSize, std::vector<PendingImage*>& rImages, std::vector<PendingImage*>& rOutLeftOver) {
+	rOutLeftOver.clear();
+	unsigned int uShelfX = 0;
+	unsigned int uShelfY = 0;
+	unsigned int uShelfHeight = 0;
+	size_t uPlaced = 0;
+	for (PendingImage* pImage : rImages) {
+		const unsigned int uWidth = pImage->m_Image.getSize().x + Padding * 2;
+		const unsigned int uHeight = pImage->m_Image.getSize().y + Padding * 2;
+		if (uShelfX + uWidth > vPageSize.x) {
+			// Images come tallest first, so the first one on a shelf sets its height
+			uShelfY += uShelfHeight;
+			uShelfX = 0;
+			uShelfHeight = 0;
+		}
+		if (uWidth > vPageSize.x || uShelfY + uHeight > vPageSize.y) {
+			rOutLeftOver.push_back(pImage);
+			continue;
+		}
+
+		pImage->m_vPosition = sf::Vector2u(uShelfX + Padding, uShelfY + Padding);
+		uShelfX += uWidth;
+		uShelfHeight = std::max(uShelfHeight, uHeight);
+		rImages[uPlaced++] = pImage;
+	}
+	rImages.resize(uPlaced);
+}
+
+const TextureAtlas::Region* TextureAtlas::Find(const std::string& name) const {
+	const auto it = m_Regions.find(GetKey(name));
+	return it != m_Regions.end() ? &it->second : nullptr;
+}
+
+const TextureAtlas::Region& TextureAtlas::Get(const std::string& name) const {
+	const Region* pRegion = Find(name);
+	if (!pRegion) {
+		throw std::runtime_error("Image '" + name + "' is not in the texture atlas");
+	}
+	return *pRegion;
+}
+
+void TextureAtlas::SetSprite(sf::Sprite& rSprite, const std::string& name) const {
+	const Region& rRegion = Get(name);
+	rSprite.setTexture(*rRegion.m_pTexture);
+	rSprite.setTextureRect(rRegion.m_Rect);
+}
+
+sf::IntRect TextureAtlas::GetRect(const std::string& name, const sf::IntRect& rLocalRect) const {
+	const Region& rRegion = Get(name);
+	return sf::IntRect(rRegion.m_Rect.left + rLocalRect.left, rRegion.m_Rect.top + rLocalRect.top, rLocalRect.width, rLocalRect.height);
+}
+
+std::string TextureAtlas::GetKey(const std::string& name) {
+	// File names are not case sensitive on Windows, "image/player.png" loads Player.png
+	std::string key(name);
+	std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return key;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Packs many small images into a few power of two textures at startup, so sprites using
+// different images still share a texture and can be drawn in one batch. Images are looked up
+// by their lower case file name, their rect on the page replaces the whole image rect.
+class TextureAtlas
+{
+public:
+	struct Region {
+		const sf::Texture* m_pTexture = nullptr;
+		sf::IntRect m_Rect;
+	};
+
+	// Loads every png in the directory. Returns how many images were added.
+	int AddDirectory(const std::string& directoryPath);
+	bool AddImage(const std::string& name, const std::string& filePath);
+
+	// Packs the added images into pages no larger than uMaxPageSize, false if one does not fit.
+	// The images are released afterwards, adding more needs another Build().
+	bool Build(unsigned int uMaxPageSize = 2048);
+
+	// nullptr if no image was added under the name
+	const Region* Find(const std::string& name) const;
+
+	// Throws if no image was added under the name, like a missing texture file would
+	const Region& Get(const std::string& name) const;
+
+	// rSprite shows the whole image, a texture rect relative to the image can be set afterwards with GetRect()
+	void SetSprite(sf::Sprite& rSprite, const std::string& name) const;
+
+	// rLocalRect of the image, moved to where the image is on its page
+	sf::IntRect GetRect(const std::string& name, const sf::IntRect& rLocalRect) const;
+
+	int GetPageCount() const {
+		return (int)m_Pages.size();
+	}
+
+private:
+	struct PendingImage {
+		std::string m_Name;
+		sf::Image m_Image;
+		sf::Vector2u m_vPosition; // On the page, set while packing
+	};
+
+	// Places as many of rImages as fit on the page, tallest first on shelves. The ones that
+	// do not fit are moved to rOutLeftOver.
+	static void PackPage(const sf::Vector2u& vPageSize, std::vector<PendingImage*>& rImages, std::vector<PendingImage*>& rOutLeftOver);
+	static std::string GetKey(const std::string& name);
+
+	std::vector<PendingImage> m_PendingImages;
+	std::vector<std::unique_ptr<sf::Texture>> m_Pages; // Regions point at them, so they never move
+	std::unordered_map<std::string, Region> m_Regions;
+};
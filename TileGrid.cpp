@@ -0,0 +1,106 @@
+#include "TileGrid.h"
+#include <algorithm>
+
+TileGrid::TileGrid()
+	: m_iWidth(0)
+	, m_iHeight(0)
+	, m_bHasSpawn(false)
+	, m_bHasEnd(false)
+{
+}
+
+void TileGrid::Clear() {
+	m_vOrigin = sf::Vector2i();
+	m_iWidth = 0;
+	m_iHeight = 0;
+	m_Cells.clear();
+	m_bHasSpawn = false;
+	m_bHasEnd = false;
+}
+
+TileGrid::Tile TileGrid::Get(Layer eLayer, const sf::Vector2i& vCoords) const {
+	return Contains(vCoords) ? m_Cells[GetCellIndex(vCoords)].m_Tiles[(int)eLayer] : Tile();
+}
+
+bool TileGrid::Set(const sf::Vector2i& vCoords, const Tile& rTile) {
+	if (rTile.IsEmpty() || Get(GetLayer(rTile.GetType()), vCoords) == rTile) {
+		return false;
+	}
+
+	// There is only one spawn and one end
+	if (rTile.GetType() == TileOptions::TileType::Spawn && m_bHasSpawn) {
+		Remove(TileOptions::TileType::Spawn, m_vSpawn);
+	}
+	else if (rTile.GetType() == TileOptions::TileType::End && m_bHasEnd) {
+		Remove(TileOptions::TileType::End, m_vEnd);
+	}
+
+	GrowToContain(vCoords);
+	Tile& rCellTile = m_Cells[GetCellIndex(vCoords)].m_Tiles[(int)GetLayer(rTile.GetType())];
+	const Tile removed = rCellTile;
+	rCellTile = rTile;
+	UpdateSpawnAndEnd(vCoords, removed, rTile);
+	return true;
+}
+
+bool TileGrid::Remove(TileOptions::TileType eType, const sf::Vector2i& vCoords) {
+	if (eType == TileOptions::TileType::Null || !Contains(vCoords)) {
+		return false;
+	}
+
+	Tile& rCellTile = m_Cells[GetCellIndex(vCoords)].m_Tiles[(int)GetLayer(eType)];
+	if (rCellTile.GetType() != eType) {
+		return false;
+	}
+
+	const Tile removed = rCellTile;
+	rCellTile = Tile();
+	UpdateSpawnAndEnd(vCoords, removed, Tile());
+	return true;
+}
+
+void TileGrid::UpdateSpawnAndEnd(const sf::Vector2i& vCoords, const Tile& rRemoved, const Tile& rPlaced) {
+	if (rRemoved.GetType() == TileOptions::TileType::Spawn) m_bHasSpawn = false;
+	if (rRemoved.GetType() == TileOptions::TileType::End) m_bHasEnd = false;
+
+	if (rPlaced.GetType() == TileOptions::TileType::Spawn) {
+		m_vSpawn = vCoords;
+		m_bHasSpawn = true;
+	}
+	else if (rPlaced.GetType() == TileOptions::TileType::End) {
+		m_vEnd = vCoords;
+		m_bHasEnd = true;
+	}
+}
+
+void TileGrid::GrowToContain(const sf::Vector2i& vCoords) {
+	if (Contains(vCoords)) {
+		return;
+	}
+
+	sf::Vector2i vMin = vCoords;
+	sf::Vector2i vMax = vCoords;
+	if (!m_Cells.empty()) {
+		const int iGrowX = std::max(m_iWidth / 2, 1);
+		const int iGrowY = std::max(m_iHeight / 2, 1);
+		vMin.x = vCoords.x < m_vOrigin.x ? std::min(vCoords.x, m_vOrigin.x - iGrowX) : m_vOrigin.x;
+		vMin.y = vCoords.y < m_vOrigin.y ? std::min(vCoords.y, m_vOrigin.y - iGrowY) : m_vOrigin.y;
+		vMax.x = vCoords.x >= m_vOrigin.x + m_iWidth ? std::max(vCoords.x, m_vOrigin.x + m_iWidth - 1 + iGrowX) : m_vOrigin.x + m_iWidth - 1;
+		vMax.y = vCoords.y >= m_vOrigin.y + m_iHeight ? std::max(vCoords.y, m_vOrigin.y + m_iHeight - 1 + iGrowY) : m_vOrigin.y + m_iHeight - 1;
+	}
+
+	const sf::Vector2i vOldOrigin = m_vOrigin;
+	const int iOldWidth = m_iWidth;
+	const int iOldHeight = m_iHeight;
+	std::vector<Cell> oldCells;
+	oldCells.swap(m_Cells);
+
+	m_vOrigin = vMin;
+	m_iWidth = vMax.x - vMin.x + 1;
+	m_iHeight = vMax.y - vMin.y + 1;
+	m_Cells.resize(m_iWidth * m_iHeight);
+	for (int y = 0; y < iOldHeight; y++) {
+		const int iRow = GetCellIndex(sf::Vector2i(vOldOrigin.x, vOldOrigin.y + y));
+		std::copy_n(oldCells.begin() + y * iOldWidth, iOldWidth, m_Cells.begin() + iRow);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "TileOptions.h"
+
+// The map's tiles in one array of cells addressed by grid coordinates. Every cell holds a ground
+// tile and a route tile (spawn, end or path), each as tile type plus atlas index, so looking up,
+// placing and removing a tile is O(1). The array grows to cover every cell a tile is placed in,
+// however far off the first screen that is. Everything else drawn or searched from the map
+// (sprites, the path graph) is built from this.
+class TileGrid
+{
+public:
+	enum class Layer : unsigned char {
+		Ground, // Aesthetic tiles
+		Route, // Spawn, end and path tiles
+		Count
+	};
+
+	struct Tile {
+		signed char m_eType = TileOptions::TileType::Null;
+		unsigned char m_uAtlasIndex = 0; // Index into the tile sheet
+
+		Tile() = default;
+		Tile(TileOptions::TileType eType, int iAtlasIndex)
+			: m_eType((signed char)eType)
+			, m_uAtlasIndex((unsigned char)iAtlasIndex)
+		{
+		}
+
+		TileOptions::TileType GetType() const {
+			return (TileOptions::TileType)m_eType;
+		}
+
+		bool IsEmpty() const {
+			return m_eType == TileOptions::TileType::Null;
+		}
+
+		bool operator==(const Tile& rOther) const {
+			return m_eType == rOther.m_eType && m_uAtlasIndex == rOther.m_uAtlasIndex;
+		}
+	};
+
+	TileGrid();
+
+	static Layer GetLayer(TileOptions::TileType eType) {
+		return eType == TileOptions::TileType::Aesthetic ? Layer::Ground : Layer::Route;
+	}
+
+	void Clear();
+
+	// Empty outside the grid
+	Tile Get(Layer eLayer, const sf::Vector2i& vCoords) const;
+
+	// Replaces whatever is in the tile's layer at vCoords, placing a spawn or end removes the previous one.
+	// False if the same tile is already there.
+	bool Set(const sf::Vector2i& vCoords, const Tile& rTile);
+
+	// Removes the tile of type eType at vCoords, false if there is none
+	bool Remove(TileOptions::TileType eType, const sf::Vector2i& vCoords);
+
+	bool HasSpawn() const {
+		return m_bHasSpawn;
+	}
+
+	const sf::Vector2i& GetSpawn() const {
+		return m_vSpawn;
+	}
+
+	bool HasEnd() const {
+		return m_bHasEnd;
+	}
+
+	const sf::Vector2i& GetEnd() const {
+		return m_vEnd;
+	}
+
+	// Calls rFunction(coords, tile) for every tile in the layer, row by row
+	template <typename Function>
+	void ForEachTile(Layer eLayer, Function&& rFunction) const {
+		for (int iCell = 0; iCell < (int)m_Cells.size(); iCell++) {
+			const Tile& rTile = m_Cells[iCell].m_Tiles[(int)eLayer];
+			if (!rTile.IsEmpty()) {
+				rFunction(sf::Vector2i(m_vOrigin.x + iCell % m_iWidth, m_vOrigin.y + iCell / m_iWidth), rTile);
+			}
+		}
+	}
+
+private:
+	struct Cell {
+		Tile m_Tiles[(int)Layer::Count];
+	};
+
+	bool Contains(const sf::Vector2i& vCoords) const {
+		return vCoords.x >= m_vOrigin.x && vCoords.y >= m_vOrigin.y && vCoords.x < m_vOrigin.x + m_iWidth && vCoords.y < m_vOrigin.y + m_iHeight;
+	}
+
+	int GetCellIndex(const sf::Vector2i& vCoords) const {
+		return (vCoords.y - m_vOrigin.y) * m_iWidth + vCoords.x - m_vOrigin.x;
+	}
+
+	// Grows by at least half the current size on the side that is too small, so placing tiles
+	// further and further out only copies the grid a logarithmic number of times
+	void GrowToContain(const sf::Vector2i& vCoords);
+
+	void UpdateSpawnAndEnd(const sf::Vector2i& vCoords, const Tile& rRemoved, const Tile& rPlaced);
+
+	sf::Vector2i m_vOrigin;
+	int m_iWidth;
+	int m_iHeight;
+	std::vector<Cell> m_Cells;
+
+	sf::Vector2i m_vSpawn;
+	sf::Vector2i m_vEnd;
+	bool m_bHasSpawn;
+	bool m_bHasEnd;
+};
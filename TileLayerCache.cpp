@@ -0,0 +1,133 @@
+#include "TileLayerCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	int FloorDivide(int iValue, int iDivisor) {
+		return (int)std::floor((float)iValue / iDivisor);
+	}
+}
+
+TileLayerCache::TileLayerCache(float fCellSize)
+	: m_fCellSize(fCellSize)
+	, m_ClearQuads(sf::Triangles)
+{
+}
+
+TileLayerCache::Chunk* TileLayerCache::FindChunk(const sf::Vector2i& vChunkCoords) {
+	for (Chunk& rChunk : m_Chunks) {
+		if (rChunk.m_vCoords == vChunkCoords) {
+			return &rChunk;
+		}
+	}
+	return nullptr;
+}
+
+void TileLayerCache::Invalidate(const sf::Vector2i& vCell) {
+	// A chunk out of view is painted whole when it comes back
+	const sf::Vector2i vChunkCoords(FloorDivide(vCell.x, ChunkWidth), FloorDivide(vCell.y, ChunkHeight));
+	Chunk* pChunk = FindChunk(vChunkCoords);
+	if (!pChunk) return;
+
+	const int iCell = (vCell.y - vChunkCoords.y * ChunkHeight) * ChunkWidth + vCell.x - vChunkCoords.x * ChunkWidth;
+	if (!pChunk->m_IsCellDirty[iCell]) {
+		pChunk->m_IsCellDirty[iCell] = 1;
+		pChunk->m_DirtyCells.push_back(vCell);
+	}
+}
+
+void TileLayerCache::InvalidateChunk(Chunk& rChunk) {
+	rChunk.m_IsCellDirty.assign(ChunkWidth * ChunkHeight, 1);
+	rChunk.m_DirtyCells.clear();
+	for (int y = 0; y < ChunkHeight; y++) {
+		for (int x = 0; x < ChunkWidth; x++) {
+			rChunk.m_DirtyCells.push_back(sf::Vector2i(rChunk.m_vCoords.x * ChunkWidth + x, rChunk.m_vCoords.y * ChunkHeight + y));
+		}
+	}
+}
+
+void TileLayerCache::Update(const sf::FloatRect& rVisibleArea) {
+	const float fChunkWidth = ChunkWidth * m_fCellSize;
+	const float fChunkHeight = ChunkHeight * m_fCellSize;
+	const sf::Vector2i vFirst((int)std::floor(rVisibleArea.left / fChunkWidth), (int)std::floor(rVisibleArea.top / fChunkHeight));
+	const sf::Vector2i vLast((int)std::floor((rVisibleArea.left + rVisibleArea.width) / fChunkWidth), (int)std::floor((rVisibleArea.top + rVisibleArea.height) / fChunkHeight));
+
+	// Chunks that left the view hand their texture back
+	const auto IsVisible = [&](const sf::Vector2i& vChunkCoords) {
+		return vChunkCoords.x >= vFirst.x && vChunkCoords.y >= vFirst.y && vChunkCoords.x <= vLast.x && vChunkCoords.y <= vLast.y;
+	};
+	for (Chunk& rChunk : m_Chunks) {
+		if (!IsVisible(rChunk.m_vCoords)) {
+			m_FreeTextures.push_back(std::move(rChunk.m_pTexture));
+		}
+	}
+	m_Chunks.erase(std::remove_if(m_Chunks.begin(), m_Chunks.end(), [](const Chunk& rChunk) { return !rChunk.m_pTexture; }), m_Chunks.end());
+
+	for (int y = vFirst.y; y <= vLast.y; y++) {
+		for (int x = vFirst.x; x <= vLast.x; x++) {
+			const sf::Vector2i vChunkCoords(x, y);
+			if (FindChunk(vChunkCoords)) continue;
+
+			Chunk& rChunk = m_Chunks.emplace_back();
+			rChunk.m_vCoords = vChunkCoords;
+			if (!m_FreeTextures.empty()) {
+				rChunk.m_pTexture = std::move(m_FreeTextures.back());
+				m_FreeTextures.pop_back();
+			}
+			else {
+				rChunk.m_pTexture = std::make_unique<sf::RenderTexture>();
+				rChunk.m_pTexture->create((unsigned)fChunkWidth, (unsigned)fChunkHeight);
+			}
+			rChunk.m_pTexture->clear(sf::Color::Transparent);
+			InvalidateChunk(rChunk);
+		}
+	}
+
+	for (Chunk& rChunk : m_Chunks) {
+		if (!rChunk.m_DirtyCells.empty()) {
+			Paint(rChunk);
+		}
+	}
+}
+
+void TileLayerCache::Paint(Chunk& rChunk) {
+	const sf::Vector2f vChunkPosition(rChunk.m_vCoords.x * ChunkWidth * m_fCellSize, rChunk.m_vCoords.y * ChunkHeight * m_fCellSize);
+
+	// Wipe the dirty cells first, without blending, so removed tiles leave no trace
+	m_ClearQuads.clear();
+	m_Batch.Begin();
+	for (const sf::Vector2i& vCell : rChunk.m_DirtyCells) {
+		const sf::Vector2f vTopLeft = sf::Vector2f(vCell.x * m_fCellSize, vCell.y * m_fCellSize) - vChunkPosition;
+		const sf::Vector2f vBottomRight = vTopLeft + sf::Vector2f(m_fCellSize, m_fCellSize);
+		m_ClearQuads.append(sf::Vertex(vTopLeft, sf::Color::Transparent));
+		m_ClearQuads.append(sf::Vertex(sf::Vector2f(vBottomRight.x, vTopLeft.y), sf::Color::Transparent));
+		m_ClearQuads.append(sf::Vertex(vBottomRight, sf::Color::Transparent));
+		m_ClearQuads.append(sf::Vertex(vTopLeft, sf::Color::Transparent));
+		m_ClearQuads.append(sf::Vertex(vBottomRight, sf::Color::Transparent));
+		m_ClearQuads.append(sf::Vertex(sf::Vector2f(vTopLeft.x, vBottomRight.y), sf::Color::Transparent));
+
+		if (m_Painter) {
+			m_Painter(vCell, m_Batch);
+		}
+	}
+	sf::RenderTexture& rTexture = *rChunk.m_pTexture;
+	rTexture.draw(m_ClearQuads, sf::RenderStates(sf::BlendNone));
+
+	sf::RenderStates states;
+	states.transform.translate(-vChunkPosition);
+	m_Batch.Draw(rTexture, states);
+	rTexture.display();
+
+	for (const sf::Vector2i& vCell : rChunk.m_DirtyCells) {
+		rChunk.m_IsCellDirty[(vCell.y - rChunk.m_vCoords.y * ChunkHeight) * ChunkWidth + vCell.x - rChunk.m_vCoords.x * ChunkWidth] = 0;
+	}
+	rChunk.m_DirtyCells.clear();
+}
+
+void TileLayerCache::Draw(sf::RenderTarget& rTarget, sf::RenderStates states) const {
+	for (const Chunk& rChunk : m_Chunks) {
+		sf::Sprite chunkSprite(rChunk.m_pTexture->getTexture());
+		chunkSprite.setPosition(rChunk.m_vCoords.x * ChunkWidth * m_fCellSize, rChunk.m_vCoords.y * ChunkHeight * m_fCellSize);
+		rTarget.draw(chunkSprite, states);
+	}
+}
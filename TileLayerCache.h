@@ -0,0 +1,56 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "SpriteBatch.h"
+
+// A tile layer pre-rendered into render textures, so drawing it costs one textured quad per chunk
+// instead of one sprite per tile. The map is cut into chunks of ChunkWidth x ChunkHeight cells,
+// one chunk covers the first screen. Only the chunks in view keep a texture, a chunk scrolling
+// into view is painted whole, after that only cells that were invalidated are painted again,
+// each into its own rect of the chunk.
+class TileLayerCache
+{
+public:
+	static constexpr int ChunkWidth = 16;
+	static constexpr int ChunkHeight = 8;
+
+	// Adds the sprites of one cell to rBatch, at their map positions
+	typedef std::function<void(const sf::Vector2i& vCell, SpriteBatch& rBatch)> CellPainter;
+
+	explicit TileLayerCache(float fCellSize = 160.0f);
+
+	void SetPainter(CellPainter painter) {
+		m_Painter = painter;
+	}
+
+	// The cell is painted again on the next Update(), if its chunk is still in view then
+	void Invalidate(const sf::Vector2i& vCell);
+
+	// Gives the chunks overlapping rVisibleArea a texture, takes it from the others, and paints the
+	// invalidated cells
+	void Update(const sf::FloatRect& rVisibleArea);
+
+	// The chunks of the last Update()
+	void Draw(sf::RenderTarget& rTarget, sf::RenderStates states = sf::RenderStates::Default) const;
+
+private:
+	struct Chunk {
+		sf::Vector2i m_vCoords; // In chunks
+		std::unique_ptr<sf::RenderTexture> m_pTexture;
+		std::vector<char> m_IsCellDirty;
+		std::vector<sf::Vector2i> m_DirtyCells;
+	};
+
+	Chunk* FindChunk(const sf::Vector2i& vChunkCoords);
+	void InvalidateChunk(Chunk& rChunk);
+	void Paint(Chunk& rChunk);
+
+	float m_fCellSize;
+	CellPainter m_Painter;
+	std::vector<Chunk> m_Chunks; // Only the few in view, looked up linearly
+	std::vector<std::unique_ptr<sf::RenderTexture>> m_FreeTextures; // Of chunks that left the view, reused before creating new ones
+	SpriteBatch m_Batch;
+	sf::VertexArray m_ClearQuads;
+};
@@ -2,5 +2,6 @@
 
 TileOptions::TileOptions(TileType m_tileType)
 	: m_tileType(m_tileType)
+	, m_archetypeId(ArchetypeRegistry::InvalidId)
 {
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define TILEOPTIONS
 
 #include <SFML/Graphics.hpp>
+#include "ArchetypeRegistry.h"
 
 class TileOptions : public sf::Drawable
 {
@@ -21,6 +22,9 @@ public:
 	const sf::Sprite& getSprite() const { return m_sprite; }
 	void setPosition(const sf::Vector2f& position) { m_sprite.setPosition(position); }
 	TileType getTileType() const { return m_tileType; }
+	// Archetype the tiles placed with this option are created from
+	void setArchetypeId(ArchetypeRegistry::Id archetypeId) { m_archetypeId = archetypeId; }
+	ArchetypeRegistry::Id getArchetypeId() const { return m_archetypeId; }
 
 	void draw(sf::RenderTarget& target, sf::RenderStates states) const override {
 		target.draw(m_sprite, states);
@@ -28,5 +32,6 @@ public:
 private:
 	sf::Sprite m_sprite;
 	TileType m_tileType;
+	ArchetypeRegistry::Id m_archetypeId;
 };
 #endif // !TILEOPTIONS
\ No newline at end of file
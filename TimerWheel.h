@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timer wheel counting in simulation ticks. Level 0 has one slot per tick for the
+// next 64 ticks, every higher level has slots 64 times as wide. A timer is stored in the slot of
+// the level that fits its distance, and moves down a level each time the level below wraps
+// around, so Advance() only touches the timers that are due and the occasional slot being
+// cascaded. Nodes are pooled, scheduling does not allocate once the pool has grown.
+template <typename T>
+class TimerWheel
+{
+public:
+	static constexpr int SlotBits = 6;
+	static constexpr int SlotCount = 1 << SlotBits;
+	static constexpr int LevelCount = 4;
+	static constexpr uint64_t MaxDelay = (1ull << (SlotBits * LevelCount)) - 1; // A bit over 3 days at 60 ticks per second
+
+	TimerWheel() {
+		Clear();
+	}
+
+	uint64_t GetCurrentTick() const {
+		return m_uCurrentTick;
+	}
+
+	// Fires rItem during the Advance() that reaches uTick, or the next one if uTick has already passed.
+	// uTick may be at most MaxDelay ahead of the current tick.
+	void Schedule(uint64_t uTick, const T& rItem) {
+		assert(uTick <= m_uCurrentTick + MaxDelay);
+		int iNode;
+		if (m_iFreeNode >= 0) {
+			iNode = m_iFreeNode;
+			m_iFreeNode = m_Nodes[iNode].m_iNext;
+		}
+		else {
+			iNode = (int)m_Nodes.size();
+			m_Nodes.push_back(Node());
+		}
+
+		Node& rNode = m_Nodes[iNode];
+		rNode.m_uTick = uTick <= m_uCurrentTick ? m_uCurrentTick + 1 : uTick <= m_uCurrentTick + MaxDelay ? uTick : m_uCurrentTick + MaxDelay;
+		rNode.m_Item = rItem;
+		Link(iNode);
+	}
+
+	// Moves to the next tick and calls rCallback(item) for every timer due at it, in the order
+	// they were scheduled. The callback may schedule new timers.
+	template <typename Callback>
+	void Advance(Callback&& rCallback) {
+		m_uCurrentTick++;
+
+		// A level that wrapped around hands the timers of its next slot down
+		for (int iLevel = 1; iLevel < LevelCount; iLevel++) {
+			if ((m_uCurrentTick & ((1ull << (SlotBits * iLevel)) - 1)) != 0) {
+				break;
+			}
+			Slot& rSlot = m_Slots[iLevel][GetSlotIndex(m_uCurrentTick, iLevel)];
+			int iNode = rSlot.m_iHead;
+			rSlot = Slot();
+			while (iNode >= 0) {
+				const int iNext = m_Nodes[iNode].m_iNext;
+				Link(iNode);
+				iNode = iNext;
+			}
+		}
+
+		Slot& rSlot = m_Slots[0][GetSlotIndex(m_uCurrentTick, 0)];
+		int iNode = rSlot.m_iHead;
+		rSlot = Slot();
+		while (iNode >= 0) {
+			Node& rNode = m_Nodes[iNode];
+			assert(rNode.m_uTick == m_uCurrentTick);
+			const int iNext = rNode.m_iNext;
+			const T item = rNode.m_Item;
+
+			// Free the node before the callback, it may schedule again
+			rNode.m_iNext = m_iFreeNode;
+			m_iFreeNode = iNode;
+			rCallback(item);
+			iNode = iNext;
+		}
+	}
+
+	// Multiplies the ticks left on every pending timer by dFactor, rounded up, for when a tick starts
+	// to stand for a different amount of time. Timers keep their order. Allocates, meant for rare changes.
+	void ScaleRemainingTicks(double dFactor) {
+		std::vector<int> pendingNodes;
+		for (auto& rLevel : m_Slots) {
+			for (Slot& rSlot : rLevel) {
+				for (int iNode = rSlot.m_iHead; iNode >= 0; iNode = m_Nodes[iNode].m_iNext) {
+					pendingNodes.push_back(iNode);
+				}
+				rSlot = Slot();
+			}
+		}
+
+		// Timers due at the same tick are in scheduling order already, sorting by tick keeps that
+		std::stable_sort(pendingNodes.begin(), pendingNodes.end(), [this](int iA, int iB) {
+			return m_Nodes[iA].m_uTick < m_Nodes[iB].m_uTick;
+			});
+		for (int iNode : pendingNodes) {
+			Node& rNode = m_Nodes[iNode];
+			const uint64_t uRemaining = (uint64_t)std::ceil((rNode.m_uTick - m_uCurrentTick) * dFactor);
+			rNode.m_uTick = m_uCurrentTick + std::clamp<uint64_t>(uRemaining, 1, MaxDelay);
+			Link(iNode);
+		}
+	}
+
+	// Drops every timer, the tick count starts over at 0
+	void Clear() {
+		for (auto& rLevel : m_Slots) {
+			for (Slot& rSlot : rLevel) {
+				rSlot = Slot();
+			}
+		}
+		m_iFreeNode = -1;
+		for (int i = (int)m_Nodes.size() - 1; i >= 0; i--) {
+			m_Nodes[i].m_iNext = m_iFreeNode;
+			m_iFreeNode = i;
+		}
+		m_uCurrentTick = 0;
+	}
+
+private:
+	struct Node {
+		uint64_t m_uTick = 0;
+		T m_Item = T();
+		int m_iNext = -1;
+	};
+
+	struct Slot {
+		int m_iHead = -1;
+		int m_iTail = -1;
+	};
+
+	static int GetSlotIndex(uint64_t uTick, int iLevel) {
+		return (int)((uTick >> (SlotBits * iLevel)) & (SlotCount - 1));
+	}
+
+	// Appends the node to the slot of the level matching the highest base 64 digit in which its
+	// tick differs from the current one. A timer cascaded on its own due tick lands in the level 0
+	// slot that Advance() empties right after the cascade.
+	void Link(int iNode) {
+		Node& rNode = m_Nodes[iNode];
+		assert(rNode.m_uTick >= m_uCurrentTick);
+
+		int iLevel = LevelCount - 1;
+		while (iLevel > 0 && (rNode.m_uTick >> (SlotBits * iLevel)) == (m_uCurrentTick >> (SlotBits * iLevel))) {
+			iLevel--;
+		}
+
+		Slot& rSlot = m_Slots[iLevel][GetSlotIndex(rNode.m_uTick, iLevel)];
+		rNode.m_iNext = -1;
+		if (rSlot.m_iTail >= 0) {
+			m_Nodes[rSlot.m_iTail].m_iNext = iNode;
+		}
+		else {
+			rSlot.m_iHead = iNode;
+		}
+		rSlot.m_iTail = iNode;
+	}
+
+	uint64_t m_uCurrentTick;
+	Slot m_Slots[LevelCount][SlotCount];
+	std::vector<Node> m_Nodes;
+	int m_iFreeNode;
+};
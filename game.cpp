@@ -8,15 +8,26 @@
 #include "DamageTextManager.h"
 #include "SoundManager.h"
 #include "MenuManager.h"
+#include "CollisionKernels.h"
+#include "AllocationCounter.h"
+
+namespace {
+    // Stats of every entity type, the look and the body are attached when the archetypes are registered
+    constexpr ArchetypeStats TowerStats = { .m_fAttackInterval = 1.0f, .m_fRange = 600.0f };
+    constexpr ArchetypeStats EnemyStats = { .m_iHealth = 3, .m_fSpeed = 250.0f, .m_iGoldReward = 1 };
+    constexpr ArchetypeStats AxeStats = { .m_fSpeed = 500.0f, .m_fAngularSpeed = 360.0f, .m_fLifetime = 3.0f, .m_iDamage = 1, .m_fKnockback = 80.0f };
+}
 
 Game::Game()
     : m_Window(sf::VideoMode({ 1920 , 1080 }), "SFML window")
+    , m_SimulationTimeStep(sf::seconds(1.0f / 60.0f))
+    , m_iMaxSubSteps(5)
+    , m_uSimulationAllocations(0)
+    , m_uRenderFrameLimit(0)
+    , m_fCameraZoom(1.0f)
     , m_eGameMode(Play)
     , m_optionIndex(0)
     , m_eScrollWheelInput(None)
-    , m_TowerTemplate(Entity::PhysicsData::Type::Static)
-    , m_enemyTemplate(Entity::PhysicsData::Type::Dynamic)
-    , m_axeTemplate(Entity::PhysicsData::Type::Dynamic)
     , m_bDrawPath(true)
     , m_iPlayerHealth(10)
     , m_iPlayerGold(10)
@@ -31,44 +42,68 @@ Game::Game()
 
     // Initialize MenuManager first
     m_MenuManager.Initialize(m_Window);
+    ResetCamera();
 
     // Initialize SoundManager
     SoundManager::getInstance().Initialize();
     SoundManager::getInstance().PlayBackgroundMusic();
 
 
-    // Load textures and check return values
-    if (!towerTexture.loadFromFile("image/player.png")) {
-        throw std::runtime_error("Failed to load player texture from 'image/player.png'");
-    }
-    if (!enemyTexture.loadFromFile("image/enemy.png")) {
-        throw std::runtime_error("Failed to load enemy texture from 'image/enemy.png'");
-    }
-    if (!axeTexture.loadFromFile("image/axe.png")) {
-        throw std::runtime_error("Failed to load axe texture from 'image/axe.png'");
+    // Load textures and check return values, a missing image throws when its sprite is set up
+    m_TextureAtlas.AddDirectory("image");
+    if (!m_TextureAtlas.Build()) {
+        throw std::runtime_error("Failed to pack the images of 'image' into the texture atlas");
     }
-
-    // Set textures for sprites
-    m_TowerTemplate.SetTexture(towerTexture);
-    m_TowerTemplate.SetScale(sf::Vector2f(5, 5));
-    m_TowerTemplate.SetOrigin(sf::Vector2f(8, 8));
-    m_TowerTemplate.setCirclePhysics(40.f);
-    m_TowerTemplate.GetPhysicsDataNonConst().setLayers(Entity::PhysicsData::Layer::Tower);
-
-    m_enemyTemplate.SetTexture(enemyTexture);
-    m_enemyTemplate.SetScale(sf::Vector2f(5, 5));
-    m_enemyTemplate.SetPosition(sf::Vector2f(960, 540));
-    m_enemyTemplate.SetOrigin(sf::Vector2f(8, 8));
-    m_enemyTemplate.setCirclePhysics(40.f); // Set the enemy as a circle with a radius of 80 pixels
-    m_enemyTemplate.GetPhysicsDataNonConst().setLayers(Entity::PhysicsData::Layer::Enemy);
-    m_enemyTemplate.SetHealth(3);
-
-    m_axeTemplate.SetTexture(axeTexture);
-    m_axeTemplate.SetScale(sf::Vector2f(5, 5));
-    m_axeTemplate.SetOrigin(sf::Vector2f(8, 8));
-    m_axeTemplate.setCirclePhysics(40.f); // Set the axe as a circle with a radius of 80 pixels
-    m_axeTemplate.GetPhysicsDataNonConst().setLayers(Entity::PhysicsData::Layer::Projectile);
-    m_axeTemplate.GetPhysicsDataNonConst().setLayersToIgnore(Entity::PhysicsData::Layer::Projectile | Entity::PhysicsData::Layer::Tower);
+    std::cout << "Texture atlas pages: " << m_TextureAtlas.GetPageCount() << std::endl;
+
+    // Register every entity type once, instances only store the archetype id
+    ArchetypeRegistry& rArchetypes = ArchetypeRegistry::getInstanceNonConst();
+
+    ArchetypeRegistry::Archetype axe;
+    m_TextureAtlas.SetSprite(axe.m_Sprite, "axe.png");
+    axe.m_Sprite.setScale(sf::Vector2f(5, 5));
+    axe.m_Sprite.setOrigin(sf::Vector2f(8, 8));
+    axe.m_BodyDef.m_eType = PhysicsWorld::Type::Dynamic;
+    axe.m_BodyDef.setCircle(40.f); // Set the axe as a circle with a radius of 80 pixels
+    axe.m_BodyDef.m_iLayers = PhysicsWorld::Layer::Projectile;
+    axe.m_Stats = AxeStats;
+    const ArchetypeRegistry::Id axeArchetype = rArchetypes.Register(axe);
+
+    ArchetypeRegistry::Archetype tower;
+    m_TextureAtlas.SetSprite(tower.m_Sprite, "player.png");
+    tower.m_Sprite.setScale(sf::Vector2f(5, 5));
+    tower.m_Sprite.setOrigin(sf::Vector2f(8, 8));
+    tower.m_BodyDef.m_eType = PhysicsWorld::Type::Static;
+    tower.m_BodyDef.setCircle(40.f);
+    tower.m_BodyDef.m_iLayers = PhysicsWorld::Layer::Tower;
+    tower.m_Stats = TowerStats;
+    tower.m_ProjectileArchetype = axeArchetype;
+    m_TowerArchetype = rArchetypes.Register(tower);
+    m_TowerPreview = tower.m_Sprite;
+
+    ArchetypeRegistry::Archetype enemy;
+    m_TextureAtlas.SetSprite(enemy.m_Sprite, "enemy.png");
+    enemy.m_Sprite.setScale(sf::Vector2f(5, 5));
+    enemy.m_Sprite.setOrigin(sf::Vector2f(8, 8));
+    enemy.m_BodyDef.m_eType = PhysicsWorld::Type::Dynamic;
+    enemy.m_BodyDef.setCircle(40.f); // Set the enemy as a circle with a radius of 80 pixels
+    enemy.m_BodyDef.m_iLayers = PhysicsWorld::Layer::Enemy;
+    enemy.m_Stats = EnemyStats;
+    m_EnemyArchetype = rArchetypes.Register(enemy);
+
+    // Axes only hit enemies
+    m_PhysicsWorld.SetLayersCollide(PhysicsWorld::Layer::Projectile, PhysicsWorld::Layer::Projectile | PhysicsWorld::Layer::Tower, false);
+
+    m_enemies.Reserve(MaxEnemies);
+    m_axes.Reserve(MaxAxes);
+
+    std::cout << "Collision kernels: " << CollisionKernels::GetInstructionSetName(CollisionKernels::GetInstructionSet()) << std::endl;
+
+    m_PhysicsWorld.SetJobSystem(&m_JobSystem);
+    m_CollisionEvents.SetThreadCount(m_JobSystem.GetThreadCount());
+    m_TargetCandidates.resize(m_JobSystem.GetThreadCount());
+    ResetTimers();
+    std::cout << "Job system threads: " << m_JobSystem.GetThreadCount() << std::endl;
 
     m_Font.loadFromFile("Fonts/Kreon-Medium.ttf");
 
@@ -76,21 +111,22 @@ Game::Game()
     m_GameModeText.setFont(m_Font);
     m_GameModeText.setString("Menu Mode");
 
-    m_PlayerText.setPosition(sf::Vector2f(1500, 100));
-    m_PlayerText.setString("Player");
-    m_PlayerText.setFont(m_Font);
+    const float fHudLineSpacing = m_Font.getLineSpacing(30);
+    m_DifficultyHud.Setup(m_Font, 30, "Difficulty: ", sf::Vector2f(1500, 100), 2);
+    m_GoldHud.Setup(m_Font, 30, "Player's Gold: ", sf::Vector2f(1500, 100 + fHudLineSpacing));
+    // Averaged every few ticks, refreshing it faster would only make it flicker
+    m_GoldPerSecondHud.Setup(m_Font, 30, "Gold Per Second: ", sf::Vector2f(1500, 100 + fHudLineSpacing * 2), 1, sf::seconds(0.25f));
 
     m_GameOverText.setPosition(sf::Vector2f(1080, 800));
     m_GameOverText.setString("GAME OVERRR");
     m_GameOverText.setFont(m_Font);
     m_GameOverText.setCharacterSize(100);
 
-    m_TileMapTexture.loadFromFile("image/TileMap.png");
     for (int j = 0; j < 4; j++) {
         for (int i = 0; i < 4; i++) {
             sf::Sprite tileSprite;
-            tileSprite.setTexture(m_TileMapTexture);
-            tileSprite.setTextureRect(sf::IntRect(i * 16, j * 16, 16, 16));
+            m_TextureAtlas.SetSprite(tileSprite, "TileMap.png");
+            tileSprite.setTextureRect(m_TextureAtlas.GetRect("TileMap.png", sf::IntRect(i * 16, j * 16, 16, 16)));
             tileSprite.setScale(sf::Vector2f(10, 10));
             tileSprite.setOrigin(sf::Vector2f(8, 8));
 
@@ -115,10 +151,20 @@ Game::Game()
 
             m_MenuManager.Initialize(m_Window);
 
+            // Each tile of the sheet is its own archetype, placed tiles only keep the id
+            ArchetypeRegistry::Archetype tile;
+            tile.m_Sprite = tileSprite;
+
             TileOptions& tileOption = m_TileOptions.emplace_back(eTileType);
             tileOption.setSprite(tileSprite);
+            tileOption.setArchetypeId(rArchetypes.Register(tile));
         }
     }
+    for (int iLayer = 0; iLayer < (int)TileGrid::Layer::Count; iLayer++) {
+        m_TileLayerCaches[iLayer].SetPainter([this, iLayer](const sf::Vector2i& vCoords, SpriteBatch& rBatch) {
+            PaintTile((TileGrid::Layer)iLayer, vCoords, rBatch);
+            });
+    }
     m_MenuManager.SetExitCallback([this]() {
         this->ExitGame();
         });
@@ -132,27 +178,80 @@ Game::~Game() {
 void Game::run() {
     sf::Clock clock;
     while (m_Window.isOpen()) {
-        m_deltaTime = clock.restart();
+        const sf::Time frameTime = clock.restart();
         HandleInput();
+        FinishRouteSearch();
+        if (m_MenuManager.IsInGamePlay() && !m_MenuManager.IsGamePaused()) {
+            UpdateCamera(frameTime);
+        }
 
         // Kiểm tra nếu đang trong menu
         if (!m_MenuManager.IsInGamePlay()) {
-            m_MenuManager.Update(m_Window, m_deltaTime.asSeconds());
+            m_MenuManager.Update(m_Window, frameTime.asSeconds());
+            m_SimulationAccumulator = sf::Time::Zero;
         }
         else {
             // Chỉ update game logic khi đang chơi và không pause
             if (!m_MenuManager.IsGamePaused()) {
                 switch (m_eGameMode) {
                 case Play:
-                    UpdatePlay();
+                {
+                    // Run as many fixed steps as the frame time covers, the rest carries over
+                    m_SimulationAccumulator += frameTime;
+                    m_deltaTime = m_SimulationTimeStep;
+                    const size_t uAllocationsBefore = AllocationCounter::GetCount();
+                    AllocationCounter::SetThreadTracked(true);
+                    int iSubSteps = 0;
+                    while (m_SimulationAccumulator >= m_SimulationTimeStep && iSubSteps < m_iMaxSubSteps) {
+                        UpdatePlay();
+                        m_SimulationAccumulator -= m_SimulationTimeStep;
+                        iSubSteps++;
+                    }
+                    m_JobSystem.WaitForAll();
+                    AllocationCounter::SetThreadTracked(false);
+                    m_uSimulationAllocations += AllocationCounter::GetCount() - uAllocationsBefore;
+
+                    // Pools only grow while warming up, after that this should stay silent
+                    m_AllocationReportTimer += frameTime;
+                    if (AllocationCounter::IsEnabled() && m_AllocationReportTimer >= sf::seconds(1.0f)) {
+                        if (m_uSimulationAllocations > 0) {
+                            std::cout << "Simulation allocated " << m_uSimulationAllocations << " times in the last second" << std::endl;
+                        }
+                        m_uSimulationAllocations = 0;
+                        m_AllocationReportTimer = sf::Time::Zero;
+                    }
+
+                    // Too slow to keep up, drop the backlog instead of spiralling
+                    if (m_SimulationAccumulator >= m_SimulationTimeStep) {
+                        m_SimulationAccumulator = m_SimulationAccumulator % m_SimulationTimeStep;
+                    }
                     break;
+                }
                 case LevelEditor:
                     UpdateLevelEditor();
+                    m_SimulationAccumulator = sf::Time::Zero;
                     break;
                 }
             }
         }
+
+        // Frame end barrier, nothing may still be running while the scene is drawn
+        m_JobSystem.WaitForAll();
+
+        // Render between the last two simulation states
+        SyncSpritesFromPhysics(m_SimulationAccumulator.asSeconds() / m_SimulationTimeStep.asSeconds());
         Draw();
+
+#ifdef _DEBUG
+        // However many sprites there are, this should stay at a handful of draw calls
+        m_RenderReportTimer += frameTime;
+        if (m_RenderReportTimer >= sf::seconds(1.0f)) {
+            const SpriteBatch::Stats& rStats = m_SpriteBatch.GetStats();
+            std::cout << "Sprites: " << rStats.m_iSprites << " in " << rStats.m_iDrawCalls << " draw calls, "
+                << rStats.m_iVertices << " vertices" << std::endl;
+            m_RenderReportTimer = sf::Time::Zero;
+        }
+#endif
     }
 }
 
@@ -175,64 +274,28 @@ void Game::UpdatePlay() {
         return;
     }
 
-    DamageTextManager::getInstanceNonConst().Update(m_deltaTime);
-    UpdateTower();
-    UpdateAxe();
-
-    const int iMaxEnemies = 30;
-    if (m_SpawnTiles.size() > 0 && !m_Paths.empty()) {
-        m_enemyTemplate.SetPosition(m_SpawnTiles[0].GetPosition());
-        if (m_enemies.size() < iMaxEnemies) {
-            static float fSpawnTimer = 0.0f;
-            //Speed up the Spawn Rate after 5 seconds
-            float fSpawnRate = m_fDifficulty;
-            // After 1 minutes, the spawn rate will be 2.2f
-            fSpawnTimer += m_deltaTime.asSeconds() * fSpawnRate;
-            if (fSpawnTimer > 1.0f) {
-                // Randomly spawn enemies
-                Entity& newEnemy = m_enemies.emplace_back(m_enemyTemplate);
-                newEnemy.SetPathIndex(rand() % m_Paths.size()); // Assign a random path index
-                fSpawnTimer = 0.0f;
-            }
-        }
-    }
-
-    for (int i = m_enemies.size() - 1; i >= 0; --i) {
-        Entity& rEnemy = m_enemies[i];
-        Path& path = m_Paths[rEnemy.GetPathIndex()];
+    AdvanceTimers();
 
-        //Find closest PathTile to the enemy
-        PathTile* pClosestTile = nullptr;
-        float fClosestDistance = std::numeric_limits<float>::max();
-
-        for (PathTile& tile : path) {
-            sf::Vector2f vEnemyToTile = tile.pCurrentTile->GetPosition() - rEnemy.GetPosition();
-            float fDistance = MathHelpers::flength(vEnemyToTile);
+    // Enemies do not move between here and the end of the jobs, so one index serves every tower
+    m_EnemyQuery.Clear();
+    for (const Entity& enemy : m_enemies) {
+        m_EnemyQuery.Insert(enemy.GetBodyId(), m_PhysicsWorld.GetPosition(enemy.GetBodyId()), PhysicsWorld::Layer::Enemy);
+    }
+    m_EnemyQuery.Build();
 
-            if (fDistance < fClosestDistance) {
-                fClosestDistance = fDistance;
-                pClosestTile = &tile;
-            }
-        }
-        // Find the next path tile
-        if (!pClosestTile || !pClosestTile->pNextTile) continue;
-        const Entity* pNextTile = pClosestTile->pNextTile;
-
-        if (pNextTile->GetClosestGridCoordinates() == m_EndTiles[0].GetClosestGridCoordinates()) {
-            if (fClosestDistance < 40.0f) {
-                // Enemy reached the end tile, remove it
-                m_enemies.erase(m_enemies.begin() + i);
-                //m_iPlayerHealth -= 1;
-                m_fDifficulty *= 0.9f;
-                continue; // Skip to the next enemy
-            }
-        }
+    // Per entity updates only read shared state, so they run on the job system. Adding and
+    // removing entities waits for all of them and happens in one place afterwards.
+    JobSystem::JobHandle damageTextJob = m_JobSystem.Schedule([this]() {
+        DamageTextManager::getInstanceNonConst().Update(m_deltaTime);
+        });
+    JobSystem::JobHandle enemyJob = m_JobSystem.Schedule([this]() { UpdateEnemySteering(); });
+    // Targeting reads the path progress the steering writes
+    JobSystem::JobHandle towerJob = m_JobSystem.Schedule([this]() { UpdateTower(); }, { enemyJob });
+    m_JobSystem.Wait(m_JobSystem.Schedule([this]() {
+        ThrowAxes();
+        RemoveEnemiesAtEnd();
+        }, { damageTextJob, towerJob, enemyJob }));
 
-        float fEnemySpeed = 250.0f;
-        sf::Vector2f vEnemyToNextTile = pNextTile->GetPosition() - rEnemy.GetPosition();
-        vEnemyToNextTile = MathHelpers::normalize(vEnemyToNextTile);
-        rEnemy.SetVelocity(vEnemyToNextTile * fEnemySpeed);
-    }
     UpdatePhysics();
     CheckForDeletionRequest();
 
@@ -244,6 +307,50 @@ void Game::UpdatePlay() {
     }
 }
 
+void Game::AdvanceTimers() {
+    m_Timers.Advance([this](const GameTimer& rTimer) { OnTimer(rTimer); });
+}
+
+void Game::OnTimer(const GameTimer& rTimer) {
+    switch (rTimer.m_eKind) {
+    case GameTimer::Kind::SpawnEnemy:
+        if (m_TileGrid.HasSpawn() && !m_Paths.empty() && m_enemies.size() < MaxEnemies) {
+            // Randomly spawn enemies
+            EntityHandle newEnemy = SpawnEntity(EntityKind::Enemy, m_EnemyArchetype, GetGridCellCenter(m_TileGrid.GetSpawn()));
+            m_enemies.Get(newEnemy)->SetPathIndex(rand() % m_Paths.size()); // Assign a random path index
+
+            // The spawn rate grows with the difficulty, after 1 minute it is 7 per second
+            m_Timers.Schedule(GetTickAfter(1.0f / m_fDifficulty), { GameTimer::Kind::SpawnEnemy, {} });
+        }
+        else {
+            // Nowhere to spawn or the pool is full, try again next tick
+            m_Timers.Schedule(m_Timers.GetCurrentTick() + 1, { GameTimer::Kind::SpawnEnemy, {} });
+        }
+        break;
+    case GameTimer::Kind::AttackReady:
+        if (rTimer.m_Entity.m_eKind == EntityKind::Tower && GetEntity(rTimer.m_Entity)) {
+            m_ReadyTowers.push_back(rTimer.m_Entity.m_Handle);
+        }
+        break;
+    case GameTimer::Kind::Expire:
+        if (Entity* pEntity = GetEntity(rTimer.m_Entity)) {
+            pEntity->RequestDeletion();
+        }
+        break;
+    }
+}
+
+void Game::ResetTimers() {
+    m_Timers.Clear();
+    m_ReadyTowers.clear();
+    m_Timers.Schedule(GetTickAfter(1.0f), { GameTimer::Kind::SpawnEnemy, {} });
+}
+
+uint64_t Game::GetTickAfter(float fSeconds) const {
+    const uint64_t uTicks = (uint64_t)std::ceil(fSeconds / m_SimulationTimeStep.asSeconds());
+    return m_Timers.GetCurrentTick() + std::max<uint64_t>(1, uTicks);
+}
+
 void Game::UpdateTower() {
 
     //Dừng update tower nếu game pause
@@ -251,61 +358,189 @@ void Game::UpdateTower() {
         return;
     }
 
-    for (Entity& tower : m_Towers) {
-        //Check if it is time to throw an axe
-        tower.m_fAttackTimer -= m_deltaTime.asSeconds();
-        if (tower.m_fAttackTimer > 0.0f) continue; // Not time to throw an axe yet
-
-        //Find the closest enemy to the tower
-        Entity* pClosestEnemy = nullptr;
-        float fClosestDistance = std::numeric_limits<float>::max();
-        for (Entity& enemy : m_enemies) {
-            sf::Vector2f vTowerToEnemy = enemy.GetPosition() - tower.GetPosition();
-            float fDistance = MathHelpers::flength(vTowerToEnemy);
-            if (fDistance < fClosestDistance) {
-                fClosestDistance = fDistance;
-                pClosestEnemy = &enemy;
+    // Only towers that can throw look for targets, ThrowAxes() creates the axes once every job is done
+    m_TowerTargets.assign(m_ReadyTowers.size(), EntityHandle());
+    m_JobSystem.ParallelFor(0, (int)m_ReadyTowers.size(), 16, [this](int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            const Entity* pTower = m_Towers.Get(m_ReadyTowers[i]);
+            if (!pTower) continue;
+            const Entity& tower = *pTower;
+
+            //Pick an enemy in range of the tower
+            const sf::Vector2f vTowerPosition = m_PhysicsWorld.GetPosition(tower.GetBodyId());
+            const PhysicsWorld::BodyId targetBody = SelectTarget(tower, vTowerPosition, m_TargetCandidates[JobSystem::GetCurrentThreadIndex()]);
+            if (targetBody != PhysicsWorld::InvalidBody) {
+                m_TowerTargets[i] = m_BodyOwners[targetBody].m_Handle;
             }
         }
+        });
+}
+
+PhysicsWorld::BodyId Game::SelectTarget(const Entity& rTower, const sf::Vector2f& vTowerPosition, vector<PhysicsWorld::BodyId>& rCandidates) const {
+    const float fRange = rTower.GetArchetype().m_Stats.m_fRange;
+    const TargetingPolicy eTargetingPolicy = rTower.GetTargetingPolicy();
+    if (eTargetingPolicy == TargetingPolicy::Closest) {
+        return m_EnemyQuery.QueryNearest(vTowerPosition, fRange, PhysicsWorld::Layer::Enemy);
+    }
+
+    // Only the enemies in range are compared, however many there are in total
+    rCandidates.clear();
+    m_EnemyQuery.QueryInRadius(vTowerPosition, fRange, PhysicsWorld::Layer::Enemy, rCandidates);
+
+    // Higher is better for every policy
+    auto GetScore = [eTargetingPolicy](const Entity& rEnemy) {
+        switch (eTargetingPolicy) {
+        case TargetingPolicy::First:
+            return rEnemy.GetPathProgress();
+        case TargetingPolicy::Last:
+            return -rEnemy.GetPathProgress();
+        case TargetingPolicy::Strongest:
+            return (float)rEnemy.getHealth();
+        case TargetingPolicy::Weakest:
+            return -(float)rEnemy.getHealth();
+        default:
+            return 0.0f;
+        }
+    };
+
+    PhysicsWorld::BodyId bestBody = PhysicsWorld::InvalidBody;
+    float fBestScore = 0.0f;
+    float fBestProgress = 0.0f;
+    for (PhysicsWorld::BodyId enemyBody : rCandidates) {
+        const Entity& rEnemy = *m_enemies.Get(m_BodyOwners[enemyBody].m_Handle);
+        const float fScore = GetScore(rEnemy);
+        const float fProgress = rEnemy.GetPathProgress();
+
+        // Ties go to the enemy furthest along, then to the lower body id, so the choice does not depend on the query order
+        const bool bBetter = bestBody == PhysicsWorld::InvalidBody
+            || fScore > fBestScore
+            || (fScore == fBestScore && (fProgress > fBestProgress || (fProgress == fBestProgress && enemyBody < bestBody)));
+        if (bBetter) {
+            bestBody = enemyBody;
+            fBestScore = fScore;
+            fBestProgress = fProgress;
+        }
+    }
+    return bestBody;
+}
 
-        if (!pClosestEnemy) {
-            continue; // No enemies in range
+void Game::ThrowAxes() {
+    // Towers that do not throw stay ready and look for a target again next update
+    int iStillReady = 0;
+    for (int i = 0; i < (int)m_ReadyTowers.size(); i++) {
+        const EntityHandle towerHandle = m_ReadyTowers[i];
+        if (!m_Towers.Contains(towerHandle)) {
+            continue;
+        }
+        const Entity* pTarget = m_enemies.Get(m_TowerTargets[i]);
+        if (!pTarget || m_axes.size() >= MaxAxes) {
+            // No enemies in range, or out of axes until one is free
+            m_ReadyTowers[iStillReady++] = towerHandle;
+            continue;
         }
+        Entity& tower = *m_Towers.Get(towerHandle);
+        const ArchetypeRegistry::Archetype& rTowerArchetype = tower.GetArchetype();
+        const ArchetypeStats& rAxeStats = ArchetypeRegistry::getInstanceConst().Get(rTowerArchetype.m_ProjectileArchetype).m_Stats;
+        const sf::Vector2f vTowerPosition = m_PhysicsWorld.GetPosition(tower.GetBodyId());
 
         // Rotate the tower to face the enemy
-        sf::Vector2f vTowerToEnemy = pClosestEnemy->GetPosition() - tower.GetPosition();
+        sf::Vector2f vTowerToEnemy = m_PhysicsWorld.GetPosition(pTarget->GetBodyId()) - vTowerPosition;
         float fAngle = MathHelpers::Angle(vTowerToEnemy);
-        tower.GetSpriteNonConst().setRotation(fAngle);
+        m_PhysicsWorld.SetRotation(tower.GetBodyId(), fAngle);
 
         //Create an axe and set its velocity
-        Entity& newAxe = m_axes.emplace_back(m_axeTemplate);
-        newAxe.SetPosition(tower.GetPosition());
+        const PhysicsWorld::BodyId axeBody = m_axes.Get(SpawnEntity(EntityKind::Axe, rTowerArchetype.m_ProjectileArchetype, vTowerPosition))->GetBodyId();
         vTowerToEnemy = MathHelpers::normalize(vTowerToEnemy);
-        newAxe.SetVelocity(vTowerToEnemy * 500.0f);
+        m_PhysicsWorld.SetVelocity(axeBody, vTowerToEnemy * rAxeStats.m_fSpeed);
+        m_PhysicsWorld.SetAngularVelocity(axeBody, rAxeStats.m_fAngularSpeed);
 
         // Play hit/attack sound
         SoundManager::getInstance().PlayHitSound();
 
         //Reset the axe throw
-        tower.m_fAttackTimer = 1.0f;
+        m_Timers.Schedule(GetTickAfter(rTowerArchetype.m_Stats.m_fAttackInterval), { GameTimer::Kind::AttackReady, { EntityKind::Tower, towerHandle } });
     }
+    m_ReadyTowers.resize(iStillReady);
+    m_TowerTargets.clear();
 }
 
-void Game::UpdateAxe() {
-
-    //Dừng update axe nếu game pause
-    if (m_MenuManager.IsGamePaused()) {
+void Game::UpdateEnemySteering() {
+    // Enemies at the end are only flagged here, RemoveEnemiesAtEnd() erases them
+    m_EnemyReachedEnd.assign(m_enemies.size(), false);
+    if (m_FlowField.IsEmpty() || !m_TileGrid.HasEnd()) {
         return;
     }
 
-    for (Entity& axe : m_axes) {
-        axe.m_fAxeTimer -= m_deltaTime.asSeconds();
-        const float fAxeRotationSpeed = 360.0f;
-        axe.GetSpriteNonConst().rotate(fAxeRotationSpeed * m_deltaTime.asSeconds());
-        if (axe.m_fAxeTimer <= 0.0f) {
-            axe.RequestDeletion();
+    m_JobSystem.ParallelFor(0, (int)m_enemies.size(), 16, [this](int iBegin, int iEnd) {
+        const float fDeltaTime = m_deltaTime.asSeconds();
+        for (int i = iBegin; i < iEnd; i++) {
+            Entity& rEnemy = m_enemies[i];
+            const sf::Vector2f vEnemyPosition = m_PhysicsWorld.GetPosition(rEnemy.GetBodyId());
+            const float fEnemySpeed = rEnemy.GetArchetype().m_Stats.m_fSpeed;
+
+            if (rEnemy.GetPathIndex() < (int)m_Paths.size()) {
+                const RoutePolyline& rRoute = m_Paths[rEnemy.GetPathIndex()];
+                RoutePolyline::Cursor& rCursor = rEnemy.GetPathCursor();
+
+                // Knockback moves the body away from its cursor. Pushed back along the route it loses that much ground,
+                // pushed sideways it walks back onto the route below.
+                const sf::Vector2f vOffset = vEnemyPosition - rRoute.GetPoint(rCursor);
+                const sf::Vector2f vDirection = rRoute.GetDirection(rCursor);
+                const float fAlongRoute = vOffset.x * vDirection.x + vOffset.y * vDirection.y;
+                if (fAlongRoute < 0.0f) {
+                    rRoute.Seek(rCursor, rCursor.m_fDistance + fAlongRoute);
+                }
+                rRoute.Seek(rCursor, rCursor.m_fDistance + fEnemySpeed * fDeltaTime);
+
+                const sf::Vector2f vEnemyToCursor = rRoute.GetPoint(rCursor) - vEnemyPosition;
+                const float fDistanceToCursor = MathHelpers::flength(vEnemyToCursor);
+                if (rCursor.m_fDistance >= rRoute.GetLength() && fDistanceToCursor < 40.0f) {
+                    // Enemy reached the end tile
+                    m_EnemyReachedEnd[i] = true;
+                    continue;
+                }
+
+                // Lands on the cursor this update unless it has to catch up, never faster than the enemy walks
+                const sf::Vector2f vVelocity = fDistanceToCursor > fEnemySpeed * fDeltaTime
+                    ? vEnemyToCursor * (fEnemySpeed / fDistanceToCursor)
+                    : vEnemyToCursor / fDeltaTime;
+                m_PhysicsWorld.SetVelocity(rEnemy.GetBodyId(), vVelocity);
+                continue;
+            }
+
+            // No route for this enemy: an edit cut the spawn off from the end, or the new routes are still
+            // being searched. The flow field is kept up to date on every edit, so it still leads the enemy to the end.
+            const sf::Vector2i vCell = GetGridCoordinates(vEnemyPosition);
+            const sf::Vector2i vNextCell = m_FlowField.GetNextCell(vCell);
+            if (vNextCell == vCell) {
+                // At the end, or the end cannot be reached from here. Stop instead of drifting on.
+                m_PhysicsWorld.SetVelocity(rEnemy.GetBodyId(), sf::Vector2f());
+                continue;
+            }
+            if (vNextCell == m_TileGrid.GetEnd()) {
+                if (MathHelpers::flength(GetGridCellCenter(vCell) - vEnemyPosition) < 40.0f) {
+                    // Enemy reached the end tile
+                    m_EnemyReachedEnd[i] = true;
+                    continue;
+                }
+            }
+
+            sf::Vector2f vEnemyToNextTile = GetGridCellCenter(vNextCell) - vEnemyPosition;
+            vEnemyToNextTile = MathHelpers::normalize(vEnemyToNextTile);
+            m_PhysicsWorld.SetVelocity(rEnemy.GetBodyId(), vEnemyToNextTile * fEnemySpeed);
         }
+        });
+}
+
+void Game::RemoveEnemiesAtEnd() {
+    for (int i = (int)m_EnemyReachedEnd.size() - 1; i >= 0; --i) {
+        if (!m_EnemyReachedEnd[i]) continue;
+
+        DespawnEntityAt(EntityKind::Enemy, i);
+        //m_iPlayerHealth -= 1;
+        m_fDifficulty *= 0.9f;
     }
+    m_EnemyReachedEnd.clear();
 }
 
 void Game::CheckForDeletionRequest() {
@@ -317,18 +552,15 @@ void Game::CheckForDeletionRequest() {
     for (int i = m_axes.size() - 1; i >= 0; i--) {
         Entity& axe = m_axes[i];
         if (axe.IsDeletionRequested()) {
-            m_axes.erase(m_axes.begin() + i);
+            DespawnEntityAt(EntityKind::Axe, i);
         }
     }
 
     for (int i = m_enemies.size() - 1; i >= 0; i--) {
         Entity& enemy = m_enemies[i];
         if (enemy.IsDeletionRequested()) {
-            m_enemies.erase(m_enemies.begin() + i);
-            //m_iPlayerGold += 1;
-            AddGold(1);
-            // Play enemy death sound
-            SoundManager::getInstance().PlayEnemyDeathSound();
+            DespawnEntityAt(EntityKind::Enemy, i);
+            // Gold and the death sound were handled by ResolveCollisionEvents()
         }
     }
 }
@@ -354,274 +586,113 @@ void Game::UpdatePhysics() {
         return;
     }
 
-    const float fMaxDeltaTime = 0.1f; // Cap the delta time to prevent large jumps
-    const float fDeltaTime = std::min(m_deltaTime.asSeconds(), fMaxDeltaTime);
-
-    vector <Entity*> AllEntities;
-
-    for (Entity& tower : m_Towers) {
-        AllEntities.push_back(&tower);
-    }
-
-    for (Entity& enemy : m_enemies) {
-        AllEntities.push_back(&enemy);
-    }
-
-    for (Entity& axe : m_axes) {
-        AllEntities.push_back(&axe);
-    }
-
-    for (Entity* entity : AllEntities) {
-        entity->GetPhysicsDataNonConst().ClearCollisions();
-    }
-
-    for (Entity* entity : AllEntities) {
-
-        if (entity->GetPhysicsData().m_eType == Entity::PhysicsData::Type::Dynamic) {
-            entity->move(entity->GetPhysicsData().m_vVelocity * fDeltaTime + entity->GetPhysicsData().m_vImpulse);
-            entity->GetPhysicsDataNonConst().ClearImpulse();
+    m_PhysicsWorld.Step(m_deltaTime.asSeconds());
 
-            // Check collisions
-            for (Entity* otherEntity : AllEntities) {
-                if (entity == otherEntity) continue; // Skip self-collision
-                if (entity->shouldIgnoreEntityForPhysics(otherEntity)) continue; // Skip ignored entities
+    // Contacts only record events, so they can be handled on every thread
+    const vector<PhysicsWorld::Contact>& rContacts = m_PhysicsWorld.GetContacts();
+    m_JobSystem.ParallelFor(0, (int)rContacts.size(), 128, [this, &rContacts](int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            const PhysicsWorld::Contact& rContact = rContacts[i];
+            const Entity* pEntityA = GetEntity(m_BodyOwners[rContact.m_BodyA]);
+            const Entity* pEntityB = GetEntity(m_BodyOwners[rContact.m_BodyB]);
+            if (!pEntityA || !pEntityB) continue;
 
-                if (!entity->GetPhysicsDataNonConst().HasCollidedThisUpdate(otherEntity) && isColiding(*entity, *otherEntity)) {
-                    entity->OnCollision(*otherEntity);
-                    otherEntity->OnCollision(*entity);
-
-                    entity->GetPhysicsDataNonConst().AddEntityCollision(otherEntity);
-                    otherEntity->GetPhysicsDataNonConst().AddEntityCollision(entity);
-                }
-                ProcessCollision(*entity, *otherEntity);
-            }
+            pEntityA->OnCollision(*pEntityB, rContact.m_Manifold.m_vNormal, m_PhysicsWorld, m_CollisionEvents);
+            pEntityB->OnCollision(*pEntityA, -rContact.m_Manifold.m_vNormal, m_PhysicsWorld, m_CollisionEvents);
         }
-    }
+        });
+
+    ResolveCollisionEvents();
 }
 
-void Game::ProcessCollision(Entity& entity1, Entity& entity2) {
-    assert(entity1.GetPhysicsData().m_eType != Entity::PhysicsData::Type::Static);
-    if (entity1.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Circle) {
-        // we are circle
-        if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Circle) {
-            // Both are circles
-            const sf::Vector2f vEntity1ToEntity2 = entity2.GetPosition() - entity1.GetPosition();
-            const float fDistanceBeeenEntities = MathHelpers::flength(vEntity1ToEntity2);
-            float fSumOfRadii = entity1.GetPhysicsData().m_fRadius + entity2.GetPhysicsData().m_fRadius;
-
-            if (fDistanceBeeenEntities < fSumOfRadii) {
-                const bool isEntity2Dynamic = entity2.GetPhysicsData().m_eType == Entity::PhysicsData::Type::Dynamic;
-                if (!isEntity2Dynamic) {
-                    // We only need to move entity1
-                    entity1.move(-MathHelpers::normalize(vEntity1ToEntity2) * (fSumOfRadii - fDistanceBeeenEntities));
-                }
-                else {
-                    // Both entities are dynamic, we need to move both of them
-                    const sf::Vector2f vEntity1ToEntity2Normalized = MathHelpers::normalize(vEntity1ToEntity2);
-                    const sf::Vector2f vEntity1Movement = vEntity1ToEntity2Normalized * (fSumOfRadii - fDistanceBeeenEntities) * 0.5f;
-                    entity1.move(-vEntity1Movement);
-                    entity2.move(vEntity1Movement);
-                }
-            }
+void Game::ResolveCollisionEvents() {
+    m_CollisionEvents.Collect(m_ResolvedEvents);
+    int iEnemiesKilled = 0;
+    int iGoldEarned = 0;
+
+    size_t iEvent = 0;
+    while (iEvent < m_ResolvedEvents.size()) {
+        const CollisionEventQueue::Event& rFirst = m_ResolvedEvents[iEvent];
+        Entity* pTarget = GetEntity(m_BodyOwners[rFirst.m_Target]);
+
+        // Every hit on the same target this update is applied as one
+        int iDamage = 0;
+        sf::Vector2f vImpulse;
+        for (; iEvent < m_ResolvedEvents.size(); iEvent++) {
+            const CollisionEventQueue::Event& rEvent = m_ResolvedEvents[iEvent];
+            if (rEvent.m_eKind != rFirst.m_eKind || rEvent.m_Target != rFirst.m_Target) break;
+
+            Entity* pSource = GetEntity(m_BodyOwners[rEvent.m_Source]);
+            const ArchetypeStats& rSourceStats = pSource->GetArchetype().m_Stats;
+            iDamage += rSourceStats.m_iDamage;
+            vImpulse += rEvent.m_vNormal * rSourceStats.m_fKnockback;
+            pSource->RequestDeletion();
         }
-        else if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Rectangle) {
-            // We are circle, they are rectangle
-            float fClosestX = std::clamp(entity1.GetPosition().x, entity2.GetPosition().x - entity2.GetPhysicsData().m_fWidth / 2, entity2.GetPosition().x + entity2.GetPhysicsData().m_fWidth / 2);
-            float fClosestY = std::clamp(entity1.GetPosition().y, entity2.GetPosition().y - entity2.GetPhysicsData().m_fHeight / 2, entity2.GetPosition().y + entity2.GetPhysicsData().m_fHeight / 2);
-
-            sf::Vector2f vClosestPoint(fClosestX, fClosestY);
-            sf::Vector2f vCircleToClosestPoint = vClosestPoint - entity1.GetPosition();
-            float fDistanceToClosestPoint = MathHelpers::flength(vCircleToClosestPoint);
-
-            if (fDistanceToClosestPoint < entity1.GetPhysicsData().m_fRadius) {
-                const bool isEntity2Dynamic = entity2.GetPhysicsData().m_eType == Entity::PhysicsData::Type::Dynamic;
-                if (!isEntity2Dynamic) {
-                    // We only need to move entity1
-                    entity1.move(-MathHelpers::normalize(vCircleToClosestPoint) * (entity1.GetPhysicsData().m_fRadius - fDistanceToClosestPoint));
-                }
-                else {
-                    const sf::Vector2f vEntity1ToEntity2Normalized = MathHelpers::normalize(vCircleToClosestPoint);
-                    const sf::Vector2f vEntity1Movement = vEntity1ToEntity2Normalized * (entity1.GetPhysicsData().m_fRadius - fDistanceToClosestPoint) * 0.5f;
-                    entity1.move(-vEntity1Movement);
-                    entity2.move(vEntity1Movement);
-                }
+
+        switch (rFirst.m_eKind) {
+        case CollisionEventQueue::Kind::ProjectileHitEnemy:
+            m_PhysicsWorld.AddImpulse(rFirst.m_Target, vImpulse);
+            pTarget->DealDamage(iDamage);
+            if (pTarget->IsDeletionRequested()) {
+                iEnemiesKilled++;
+                iGoldEarned += pTarget->GetArchetype().m_Stats.m_iGoldReward;
             }
+            break;
         }
     }
-    else if (entity1.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Rectangle) {
-        // we are rectangle
-        if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Rectangle) {
-            // Both are rectangles
-            float fDistanceX = std::abs(entity1.GetPosition().x - entity2.GetPosition().x);
-            float fDistanceY = std::abs(entity1.GetPosition().y - entity2.GetPosition().y);
-
-            float fOverlapX = (entity1.GetPhysicsData().m_fWidth + entity2.GetPhysicsData().m_fWidth) / 2 - fDistanceX;
-            float fOverlapY = (entity1.GetPhysicsData().m_fHeight + entity2.GetPhysicsData().m_fHeight) / 2 - fDistanceY;
-            if (fOverlapX > 0 && fOverlapY > 0) {
-                const bool isEntity2Dynamic = entity2.GetPhysicsData().m_eType == Entity::PhysicsData::Type::Dynamic;
-                // Guarantee a collision
-                if (fOverlapX < fOverlapY) {
-                    if (entity1.GetPosition().x < entity2.GetPosition().x) {
-                        if (isEntity2Dynamic) {
-                            entity1.move(sf::Vector2f(-fOverlapX / 2, 0));
-                            entity2.move(sf::Vector2f(fOverlapX / 2, 0));
-                        }
-                        else {
-                            entity1.move(sf::Vector2f(-fOverlapX, 0));
-                        }
-                    }
-                    else {
-                        if (isEntity2Dynamic) {
-                            entity1.move(sf::Vector2f(fOverlapX / 2, 0));
-                            entity2.move(sf::Vector2f(-fOverlapX / 2, 0));
-                        }
-                        else {
-                            entity1.move(sf::Vector2f(fOverlapX, 0));
-                        }
-                    }
-                }
-                else {
-                    if (entity1.GetPosition().y < entity2.GetPosition().y) {
-                        if (isEntity2Dynamic) {
-                            entity1.move(sf::Vector2f(0, -fOverlapY / 2));
-                            entity2.move(sf::Vector2f(0, fOverlapY / 2));
-                        }
-                        else {
-                            entity1.move(sf::Vector2f(0, -fOverlapY));
-                        }
-                    }
-                    else {
-                        if (isEntity2Dynamic) {
-                            entity1.move(sf::Vector2f(0, fOverlapY / 2));
-                            entity2.move(sf::Vector2f(0, -fOverlapY / 2));
-                        }
-                        else {
-                            entity1.move(sf::Vector2f(0, fOverlapY));
-                        }
-                    }
-                }
-            }
-        }
-        else if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Circle) {
-            // We are rectangle, they are circle
-            float fClosestX = std::clamp(entity2.GetPosition().x, entity1.GetPosition().x - entity1.GetPhysicsData().m_fWidth / 2, entity1.GetPosition().x + entity1.GetPhysicsData().m_fWidth / 2);
-            float fClosestY = std::clamp(entity2.GetPosition().y, entity1.GetPosition().y - entity1.GetPhysicsData().m_fHeight / 2, entity1.GetPosition().y + entity1.GetPhysicsData().m_fHeight / 2);
-
-            sf::Vector2f vClosestPoint(fClosestX, fClosestY);
-            sf::Vector2f vCircleToClosestPoint = vClosestPoint - entity2.GetPosition();
-            float fDistanceToClosestPoint = MathHelpers::flength(vCircleToClosestPoint);
-
-            if (fDistanceToClosestPoint < entity2.GetPhysicsData().m_fRadius) {
-                const bool isEntity2Dynamic = entity2.GetPhysicsData().m_eType == Entity::PhysicsData::Type::Dynamic;
-                if (!isEntity2Dynamic) {
-                    // We only need to move entity1
-                    entity1.move(MathHelpers::normalize(vCircleToClosestPoint) * (entity2.GetPhysicsData().m_fRadius - fDistanceToClosestPoint));
-                }
-                else {
-                    const sf::Vector2f vEntity2ToEntity1Normalized = MathHelpers::normalize(vCircleToClosestPoint);
-                    const sf::Vector2f vEntity2Movement = vEntity2ToEntity1Normalized * (entity2.GetPhysicsData().m_fRadius - fDistanceToClosestPoint) * 0.5f;
-                    entity1.move(vEntity2Movement);
-                    entity2.move(-vEntity2Movement);
-                }
-            }
-        }
+
+    if (iEnemiesKilled > 0) {
+        AddGold(iGoldEarned);
+        // One death sound however many enemies died this update
+        SoundManager::getInstance().PlayEnemyDeathSound();
     }
 }
 
-bool Game::isColiding(const Entity& entity1, const Entity& entity2) {
-    if (entity1.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Circle) {
-        // we are circle
-        if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Circle) {
-            // Both are circles
-            const sf::Vector2f vEntity1ToEntity2 = entity2.GetPosition() - entity1.GetPosition();
-            const float fDistanceBeeenEntities = MathHelpers::flength(vEntity1ToEntity2);
-            float fSumOfRadii = entity1.GetPhysicsData().m_fRadius + entity2.GetPhysicsData().m_fRadius;
-
-            if (fDistanceBeeenEntities < fSumOfRadii) {
-                return true;
-            }
-        }
-        else if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Rectangle) {
-            // We are circle, they are rectangle
-            float fClosestX = std::clamp(entity1.GetPosition().x, entity2.GetPosition().x - entity2.GetPhysicsData().m_fWidth / 2, entity2.GetPosition().x + entity2.GetPhysicsData().m_fWidth / 2);
-            float fClosestY = std::clamp(entity1.GetPosition().y, entity2.GetPosition().y - entity2.GetPhysicsData().m_fHeight / 2, entity2.GetPosition().y + entity2.GetPhysicsData().m_fHeight / 2);
-
-            sf::Vector2f vClosestPoint(fClosestX, fClosestY);
-            sf::Vector2f vCircleToClosestPoint = vClosestPoint - entity1.GetPosition();
-            float fDistanceToClosestPoint = MathHelpers::flength(vCircleToClosestPoint);
-
-            if (fDistanceToClosestPoint < entity1.GetPhysicsData().m_fRadius) {
-                return true;
-            }
-        }
+void Game::SyncSpritesFromPhysics(float fAlpha) {
+    for (Entity& tower : m_Towers) {
+        tower.SetPosition(m_PhysicsWorld.GetInterpolatedPosition(tower.GetBodyId(), fAlpha));
+        tower.SetRotation(m_PhysicsWorld.GetInterpolatedRotation(tower.GetBodyId(), fAlpha));
     }
-    else if (entity1.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Rectangle) {
-        // we are rectangle
-        if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Rectangle) {
-            // Both are rectangles
-            float fDistanceX = std::abs(entity1.GetPosition().x - entity2.GetPosition().x);
-            float fDistanceY = std::abs(entity1.GetPosition().y - entity2.GetPosition().y);
-
-            float fOverlapX = (entity1.GetPhysicsData().m_fWidth + entity2.GetPhysicsData().m_fWidth) / 2 - fDistanceX;
-            float fOverlapY = (entity1.GetPhysicsData().m_fHeight + entity2.GetPhysicsData().m_fHeight) / 2 - fDistanceY;
-            if (fOverlapX > 0 && fOverlapY > 0) {
-                return true;
-            }
-        }
-        else if (entity2.GetPhysicsData().m_eShape == Entity::PhysicsData::Shape::Circle) {
-            // We are rectangle, they are circle
-            float fClosestX = std::clamp(entity2.GetPosition().x, entity1.GetPosition().x - entity1.GetPhysicsData().m_fWidth / 2, entity1.GetPosition().x + entity1.GetPhysicsData().m_fWidth / 2);
-            float fClosestY = std::clamp(entity2.GetPosition().y, entity1.GetPosition().y - entity1.GetPhysicsData().m_fHeight / 2, entity1.GetPosition().y + entity1.GetPhysicsData().m_fHeight / 2);
 
-            sf::Vector2f vClosestPoint(fClosestX, fClosestY);
-            sf::Vector2f vCircleToClosestPoint = vClosestPoint - entity2.GetPosition();
-            float fDistanceToClosestPoint = MathHelpers::flength(vCircleToClosestPoint);
+    for (Entity& enemy : m_enemies) {
+        enemy.SetPosition(m_PhysicsWorld.GetInterpolatedPosition(enemy.GetBodyId(), fAlpha));
+    }
 
-            if (fDistanceToClosestPoint < entity2.GetPhysicsData().m_fRadius) {
-                return true;
-            }
-        }
+    for (Entity& axe : m_axes) {
+        axe.SetPosition(m_PhysicsWorld.GetInterpolatedPosition(axe.GetBodyId(), fAlpha));
+        axe.SetRotation(m_PhysicsWorld.GetInterpolatedRotation(axe.GetBodyId(), fAlpha));
     }
-    return false;
 }
 
 void Game::DrawPlay() {
-    sf::Vector2f vMousePosition = (sf::Vector2f)sf::Mouse::getPosition(m_Window);
-    m_TowerTemplate.SetPosition(vMousePosition);
+    sf::Vector2f vMousePosition = GetMouseWorldPosition();
+    m_TowerPreview.setPosition(vMousePosition);
 
     if (CanPlaceTowerAtPosition(vMousePosition)) {
-        m_TowerTemplate.SetColor(sf::Color::Green);
+        m_TowerPreview.setColor(sf::Color::Green);
     }
     else {
-        m_TowerTemplate.SetColor(sf::Color::Red);
-    }
-
-    for (const Entity& tower : m_Towers) {
-        m_Window.draw(tower);
+        m_TowerPreview.setColor(sf::Color::Red);
     }
 
-    for (const Entity& enemy : m_enemies) {
-        m_Window.draw(enemy);
-    }
-
-    for (const Entity& axe : m_axes) {
-        m_Window.draw(axe);
-    }
+    DamageTextManager::getInstanceConst().Draw(m_Window, GetVisibleArea(0.0f));
 
-    DamageTextManager::getInstanceConst().Draw(m_Window);
 
+    m_Window.draw(m_TowerPreview); // Draw the tower preview
+}
 
-    m_Window.draw(m_TowerTemplate); // Draw the tower template
-
+void Game::DrawPlayHud() {
     if (m_iPlayerHealth <= 0) {
         //draw the game over text
         m_Window.draw(m_GameOverText);
     }
 
-    m_PlayerText.setString("Difficulty: " + to_string(m_fDifficulty) +
-        "\nPlayer's Gold: " + to_string(m_iPlayerGold) +
-        "\nGold Per Second: " + to_string(m_fGoldPerSecond));
-    m_Window.draw(m_PlayerText);
+    m_DifficultyHud.SetValue(m_fDifficulty);
+    m_GoldHud.SetValue(m_iPlayerGold);
+    m_GoldPerSecondHud.SetValue(m_fGoldPerSecond);
+    m_DifficultyHud.Draw(m_Window);
+    m_GoldHud.Draw(m_Window);
+    m_GoldPerSecondHud.Draw(m_Window);
 }
 
 void Game::Draw() {
@@ -634,12 +705,31 @@ void Game::Draw() {
     }
     else {
         // Vẽ game content khi đang chơi
-        for (const Entity& entity : m_AestheticTiles) {
-            m_Window.draw(entity);
-        }
+        // Nothing outside the camera reaches the renderer, entities get a cell of slack for their rotated sprites
+        m_Window.setView(m_Camera);
+        const sf::FloatRect visibleArea = GetVisibleArea(0.0f);
+        const sf::FloatRect entityArea = GetVisibleArea(160.0f);
 
-        // Draw the game mode text 
-        m_Window.draw(m_GameModeText);
+        TileLayerCache& rGroundCache = m_TileLayerCaches[(int)TileGrid::Layer::Ground];
+        rGroundCache.Update(visibleArea);
+        rGroundCache.Draw(m_Window);
+
+        m_SpriteBatch.Begin();
+        switch (m_eGameMode) {
+        case Play:
+            BatchEntities(m_Towers, TowerSprites, entityArea);
+            BatchEntities(m_enemies, EnemySprites, entityArea);
+            BatchEntities(m_axes, AxeSprites, entityArea);
+            break;
+        case LevelEditor:
+            if (m_bDrawPath) {
+                TileLayerCache& rRouteCache = m_TileLayerCaches[(int)TileGrid::Layer::Route];
+                rRouteCache.Update(visibleArea);
+                rRouteCache.Draw(m_Window);
+            }
+            break;
+        }
+        m_SpriteBatch.Draw(m_Window);
 
         switch (m_eGameMode) {
         case Play:
@@ -650,6 +740,15 @@ void Game::Draw() {
             break;
         }
 
+        m_Window.setView(m_Window.getDefaultView());
+
+        // Draw the game mode text 
+        m_Window.draw(m_GameModeText);
+
+        if (m_eGameMode == Play) {
+            DrawPlayHud();
+        }
+
         if (m_MenuManager.IsGamePaused()) {
             m_MenuManager.Draw(m_Window);
         }
@@ -669,6 +768,11 @@ void Game::HandleInput() {
             return;
         }
 
+        // The camera sees more of the world in a bigger window instead of stretching it
+        if (event.type == sf::Event::Resized) {
+            m_Camera.setSize(event.size.width * m_fCameraZoom, event.size.height * m_fCameraZoom);
+        }
+
         // Nếu đang trong menu, chuyển input cho MenuManager
         if (!m_MenuManager.IsInGamePlay()) {
             m_MenuManager.HandleInput(event, m_Window);
@@ -716,9 +820,20 @@ void Game::HandleInput() {
 
 void Game::HandleGameInput(sf::Event& event) {
     switch (event.type) {
+    case sf::Event::MouseButtonPressed:
+        // Right clicking a tower switches how it picks its targets
+        if (event.mouseButton.button == sf::Mouse::Right && m_eGameMode == Play) {
+            CycleTowerTargetingAtPosition(m_Window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y), m_Camera));
+        }
+        break;
     case sf::Event::MouseWheelScrolled:
         if (event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel) {
-            if (event.mouseWheelScroll.delta > 0) {
+            // The wheel zooms, in the level editor it picks the tile unless control is held
+            if (m_eGameMode == Play || sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)) {
+                const sf::Vector2i vPixel(event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+                ZoomCamera(event.mouseWheelScroll.delta > 0 ? 1.0f / CameraZoomStep : CameraZoomStep, vPixel);
+            }
+            else if (event.mouseWheelScroll.delta > 0) {
                 m_eScrollWheelInput = ScrollUp;
             }
             else {
@@ -731,6 +846,32 @@ void Game::HandleGameInput(sf::Event& event) {
         if (event.key.code == sf::Keyboard::Escape) {
             m_MenuManager.TogglePauseMenu();
         }
+        // F1 switches the physics broadphase to brute force so both can be compared
+        else if (event.key.code == sf::Keyboard::F1) {
+            m_PhysicsWorld.SetBruteForceBroadphase(!m_PhysicsWorld.IsBruteForceBroadphase());
+            std::cout << "Broadphase: " << (m_PhysicsWorld.IsBruteForceBroadphase() ? "brute force" : "spatial hash grid") << std::endl;
+        }
+        // F2 steps the collision kernels down to a narrower instruction set, wrapping back to the widest
+        else if (event.key.code == sf::Keyboard::F2) {
+            if (CollisionKernels::GetInstructionSet() == CollisionKernels::InstructionSet::Scalar) {
+                CollisionKernels::SetInstructionSet(CollisionKernels::InstructionSet::AVX2);
+            }
+            else {
+                CollisionKernels::SetInstructionSet((CollisionKernels::InstructionSet)((int)CollisionKernels::GetInstructionSet() - 1));
+            }
+            std::cout << "Collision kernels: " << CollisionKernels::GetInstructionSetName(CollisionKernels::GetInstructionSet()) << std::endl;
+        }
+        // F3 cycles the simulation rate through 30, 60 and 120 ticks per second, gameplay speed and pending timers stay the same
+        else if (event.key.code == sf::Keyboard::F3) {
+            const float fTicksPerSecond = std::round(1.0f / m_SimulationTimeStep.asSeconds());
+            SetSimulationRate(fTicksPerSecond >= 120.0f ? 30.0f : fTicksPerSecond * 2.0f);
+            std::cout << "Simulation rate: " << std::round(1.0f / m_SimulationTimeStep.asSeconds()) << " ticks per second" << std::endl;
+        }
+        // F4 switches rendering between unlimited and 60 frames per second
+        else if (event.key.code == sf::Keyboard::F4) {
+            SetRenderFrameLimit(m_uRenderFrameLimit == 0 ? 60 : 0);
+            std::cout << "Frame limit: " << (m_uRenderFrameLimit == 0 ? "none" : std::to_string(m_uRenderFrameLimit)) << std::endl;
+        }
         // Thêm phím Tab để chuyển đổi giữa Play và Level Editor (chỉ khi đang trong game)
         else if (event.key.code == sf::Keyboard::Tab) {
             if (m_eGameMode == Play) {
@@ -824,6 +965,11 @@ void Game::ResetGameState() {
     m_enemies.clear();
     m_axes.clear();
     m_Towers.clear();
+    m_PhysicsWorld.Clear();
+    m_BodyOwners.clear();
+    m_CollisionEvents.Clear();
+    ResetTimers();
+    ResetCamera();
 
     m_iPlayerHealth = 10;
     m_iPlayerGold = 10;
@@ -836,152 +982,170 @@ void Game::ResetGameState() {
 }
 
 void Game::CreateTileAtPosition(const sf::Vector2f& pos) {
-    int x = pos.x / 160;
-    int y = pos.y / 160;
-
     TileOptions::TileType eTileType = m_TileOptions[m_optionIndex].getTileType();
     if (eTileType == TileOptions::TileType::Null) return;
 
-    vector<Entity>& ListOfTiles = GetListOfTiles(eTileType);
-
-    if (eTileType == TileOptions::TileType::Spawn || eTileType == TileOptions::TileType::End) {
-        ListOfTiles.clear(); // Clear existing spawn or end tiles (if more than 1)
+    // Floored, the camera can scroll to negative coordinates
+    const sf::Vector2i vCoords = GetGridCoordinates(pos);
+    const TileGrid::Layer eLayer = TileGrid::GetLayer(eTileType);
+    const TileOptions::TileType eReplacedType = m_TileGrid.Get(eLayer, vCoords).GetType();
+    // Placing a spawn or end moves it, the cell it leaves has to be repainted too
+    const bool bHadSpawn = m_TileGrid.HasSpawn();
+    const bool bHadEnd = m_TileGrid.HasEnd();
+    const sf::Vector2i vOldSpawn = bHadSpawn ? m_TileGrid.GetSpawn() : vCoords;
+    const sf::Vector2i vOldEnd = bHadEnd ? m_TileGrid.GetEnd() : vCoords;
+    if (!m_TileGrid.Set(vCoords, TileGrid::Tile(eTileType, m_optionIndex))) {
+        return; // The same tile is already there, which is every frame while the mouse is held
     }
 
-    sf::Sprite tile = m_TileOptions[m_optionIndex].getSprite();
-    tile.setPosition(x * 160 + 80, y * 160 + 80);
-
-    for (int i = 0; i < ListOfTiles.size(); i++) {
-        if (ListOfTiles[i].GetPosition() == tile.getPosition()) {
-            ListOfTiles[i] = ListOfTiles.back(); // Move the last tile to the current position
-            ListOfTiles.pop_back(); // Remove the last tile
-            break; // Tile already exists at this position, do not add a duplicate
-        }
+    InvalidateTile(vCoords);
+    if (eTileType == TileOptions::TileType::Spawn && bHadSpawn) {
+        InvalidateTile(vOldSpawn);
+    }
+    else if (eTileType == TileOptions::TileType::End && bHadEnd) {
+        InvalidateTile(vOldEnd);
     }
 
-    Entity& new_tiles = ListOfTiles.emplace_back(Entity::PhysicsData::Type::Static);
-    new_tiles.SetSprite(tile);
-    new_tiles.setRectanglePhysics(160.0f, 160.0f);
-    ConstructionPath();
+    if (eLayer == TileGrid::Layer::Route) {
+        UpdatePathsAfterEdit(vCoords, eReplacedType, eTileType);
+    }
 }
 
 void Game::DeleteTileAtPosition(const sf::Vector2f& pos) {
-    int x = pos.x / 160;
-    int y = pos.y / 160;
-
-    // Calculate the tile position based on the grid size (160x160)
-    sf::Vector2f tilePosition(x * 160 + 80, y * 160 + 80);
-
     TileOptions::TileType eTileType = m_TileOptions[m_optionIndex].getTileType();
     if (eTileType == TileOptions::TileType::Null) return;
-    vector<Entity>& ListOfTiles = GetListOfTiles(eTileType);
 
-    for (int i = 0; i < ListOfTiles.size(); i++) {
-        if (ListOfTiles[i].GetPosition() == tilePosition) {
-            ListOfTiles[i] = ListOfTiles.back(); // Move the last tile to the current position
-            ListOfTiles.pop_back(); // Remove the last tile
-            break; // Tile found and removed
-        }
+    const sf::Vector2i vCoords = GetGridCoordinates(pos);
+    if (!m_TileGrid.Remove(eTileType, vCoords)) {
+        return;
+    }
+
+    InvalidateTile(vCoords);
+    if (TileGrid::GetLayer(eTileType) == TileGrid::Layer::Route) {
+        UpdatePathsAfterEdit(vCoords, eTileType, TileOptions::TileType::Null);
     }
 }
 
-void Game::ConstructionPath() {
-    m_Paths.clear();
-    if (m_SpawnTiles.empty() || m_EndTiles.empty()) {
+void Game::UpdatePathsAfterEdit(const sf::Vector2i& vCoords, TileOptions::TileType eRemovedType, TileOptions::TileType ePlacedType) {
+    const auto IsSpawnOrEnd = [](TileOptions::TileType eType) {
+        return eType == TileOptions::TileType::Spawn || eType == TileOptions::TileType::End;
+    };
+    if (IsSpawnOrEnd(eRemovedType) || IsSpawnOrEnd(ePlacedType)) {
+        ConstructionPath();
         return;
     }
+    if (m_FlowField.IsEmpty()) {
+        return; // No spawn or end yet, ConstructionPath() picks the tile up once there are
+    }
 
-    Path newPath;
-    PathTile& start = newPath.emplace_back();
-    start.pCurrentTile = &m_SpawnTiles[0];
-
-    sf::Vector2i vEndCoords = m_EndTiles[0].GetClosestGridCoordinates();
-    VisitPathNeighbors(newPath, vEndCoords);
+    // A single path tile only changes the edges around it, so the graph and the flow field are
+    // patched in place and only the routes are searched again
+    if (ePlacedType == TileOptions::TileType::Path) {
+        if (m_PathGraph.FindNode(vCoords) >= 0) return;
+        m_PathGraph.InsertNode(vCoords);
+    }
+    else if (!m_PathGraph.RemoveNode(vCoords)) {
+        return;
+    }
+    if (!m_FlowField.Repair(m_PathGraph, vCoords)) {
+        m_FlowField.Build(m_PathGraph, m_PathGraph.FindNode(m_TileGrid.GetEnd()), FlowFieldMargin);
+    }
+    StartRouteSearch();
 }
 
-void Game::VisitPathNeighbors(Path path, const sf::Vector2i& rEndCoords) {
-    const sf::Vector2i vCurrentTilePosition = path.back().pCurrentTile->GetClosestGridCoordinates();
+void Game::ConstructionPath() {
+    m_PathGraph.Clear();
+    m_FlowField.Clear();
+    if (!m_TileGrid.HasSpawn() || !m_TileGrid.HasEnd()) {
+        StartRouteSearch();
+        return;
+    }
 
-    const sf::Vector2i vNorthCoords(vCurrentTilePosition.x, vCurrentTilePosition.y - 1);
-    const sf::Vector2i vEastCoords(vCurrentTilePosition.x + 1, vCurrentTilePosition.y);
-    const sf::Vector2i vSouthCoords(vCurrentTilePosition.x, vCurrentTilePosition.y + 1);
-    const sf::Vector2i vWestCoords(vCurrentTilePosition.x - 1, vCurrentTilePosition.y);
+    m_PathGraph.AddNode(m_TileGrid.GetSpawn());
+    const int iEndNode = m_PathGraph.AddNode(m_TileGrid.GetEnd());
+    m_TileGrid.ForEachTile(TileGrid::Layer::Route, [this](const sf::Vector2i& vCoords, const TileGrid::Tile& rTile) {
+        if (rTile.GetType() == TileOptions::TileType::Path) {
+            m_PathGraph.AddNode(vCoords);
+        }
+        });
+    m_PathGraph.Build();
+    // Paths next to the end tile go straight into it instead of walking around it
+    m_PathGraph.MakeSink(iEndNode);
 
-    if (rEndCoords == vNorthCoords || rEndCoords == vEastCoords || rEndCoords == vSouthCoords || rEndCoords == vWestCoords) {
-        // Set the last tile in our current path to point to the next tile
-        path.back().pNextTile = &m_EndTiles[0];
-        // Add the next tile, and set it.
-        PathTile& newTile = path.emplace_back();
-        newTile.pCurrentTile = &m_EndTiles[0];
-        m_Paths.push_back(path);
+    // Off-path cells next to the path lead back onto it, for enemies without a route
+    m_FlowField.Build(m_PathGraph, iEndNode, FlowFieldMargin);
+    StartRouteSearch();
+}
 
-        // If any of our paths are next to the end tile, they should probably go straight to end and terminate.
-        // If we didn't return here, we could move around the end tile before going into it.
+void Game::StartRouteSearch() {
+    // Until the new routes are in, every enemy follows the flow field, which is already up to date
+    m_Paths.clear();
+    if (m_RouteSearch.valid()) {
+        m_bRouteSearchOutdated = true; // Searched again once the running search is done
+        return;
+    }
+    m_bRouteSearchOutdated = false;
+    if (m_FlowField.IsEmpty()) {
         return;
     }
 
-    const vector<Entity>& pathTiles = GetListOfTiles(TileOptions::TileType::Path);
-
-    for (const Entity& pathTile : pathTiles) {
-        const sf::Vector2i vPathTileCoords = pathTile.GetClosestGridCoordinates();
+    // Not a JobSystem job, the frame end barrier would wait for it
+    m_RouteSearch = std::async(std::launch::async, &Game::FindRoutes, m_PathGraph, m_TileGrid.GetSpawn(), m_TileGrid.GetEnd());
+}
 
-        if (DoesPathContainCoordinates(path, vPathTileCoords)) {
-            continue; // Skip if the path already contains this tile
-        }
+void Game::FinishRouteSearch() {
+    if (!m_RouteSearch.valid() || m_RouteSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
 
-        if (vPathTileCoords == vNorthCoords || vPathTileCoords == vEastCoords || vPathTileCoords == vSouthCoords || vPathTileCoords == vWestCoords) {
-            // We have a neighbor tile
-            Path newPath = path; // Create a copy of the current path
-            newPath.back().pNextTile = &pathTile; // Set the next tile in the path
-            PathTile& newTile = newPath.emplace_back();
-            newTile.pCurrentTile = &pathTile;
+    RouteSearchResult result = m_RouteSearch.get();
+    if (m_bRouteSearchOutdated) {
+        StartRouteSearch();
+        return;
+    }
+    m_Paths = std::move(result.m_Paths);
 
-            if (vPathTileCoords == rEndCoords) {
-                // We reached the end tile
-                m_Paths.push_back(newPath);
-            }
-            else {
-                // Continue visiting neighbors
-                VisitPathNeighbors(newPath, rEndCoords);
-            }
+    // Enemies already walking pick up where they stand on the new routes
+    for (Entity& rEnemy : m_enemies) {
+        if (m_Paths.empty()) break;
+        if (rEnemy.GetPathIndex() >= (int)m_Paths.size()) {
+            rEnemy.SetPathIndex(rand() % m_Paths.size());
         }
+        rEnemy.GetPathCursor() = m_Paths[rEnemy.GetPathIndex()].Project(m_PhysicsWorld.GetPosition(rEnemy.GetBodyId()));
     }
+
+    std::cout << "Paths: " << m_Paths.size() << " routes over " << result.m_iNodeCount << " tiles in "
+        << result.m_fMilliseconds << " ms" << std::endl;
 }
 
-bool Game::DoesPathContainCoordinates(const Path& path, const sf::Vector2i& coords) {
-    for (const PathTile& tile : path) {
-        if (tile.pCurrentTile->GetClosestGridCoordinates() == coords) {
-            return true; // Found a tile with the same coordinates
+Game::RouteSearchResult Game::FindRoutes(const PathGraph& rGraph, const sf::Vector2i& vSpawn, const sf::Vector2i& vEnd) {
+    sf::Clock searchClock;
+    RouteSearchResult result;
+    result.m_iNodeCount = rGraph.GetNodeCount();
+
+    vector<PathGraph::Route> routes;
+    rGraph.FindShortestRoutes(rGraph.FindNode(vSpawn), rGraph.FindNode(vEnd), MaxPaths, routes);
+    for (const PathGraph::Route& rRoute : routes) {
+        RoutePolyline& rPath = result.m_Paths.emplace_back();
+        for (int iNode : rRoute) {
+            rPath.AddPoint(GetGridCellCenter(rGraph.GetCoords(iNode)));
         }
     }
-    return false; // No tile with the same coordinates found
+
+    result.m_fMilliseconds = searchClock.getElapsedTime().asMicroseconds() / 1000.0f;
+    return result;
 }
 
 void Game::DrawLevelEditor() {
-    sf::Vector2f vMousePosition = (sf::Vector2f)sf::Mouse::getPosition(m_Window);
+    sf::Vector2f vMousePosition = GetMouseWorldPosition();
     m_TileOptions[m_optionIndex].setPosition(vMousePosition);
 
-    TileOptions::TileType eTileType = m_TileOptions[m_optionIndex].getTileType();
-
-    if (m_bDrawPath) {
-        for (const Entity& entity : m_SpawnTiles) {
-            m_Window.draw(entity);
-        }
-
-        for (const Entity& entity : m_EndTiles) {
-            m_Window.draw(entity);
-        }
-
-        for (const Entity& entity : m_PathTiles) {
-            m_Window.draw(entity);
-        }
-    }
     m_Window.draw(m_TileOptions[m_optionIndex]);
 }
 
 void Game::HandlePlayInput() {
     if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
-        sf::Vector2f vMousePosition = (sf::Vector2f)sf::Mouse::getPosition(m_Window);
+        sf::Vector2f vMousePosition = GetMouseWorldPosition();
         if (m_iPlayerGold >= 3) {
             if (CreateTowerAtPosition(vMousePosition)) {
                 m_iPlayerGold -= 3;
@@ -1006,35 +1170,135 @@ void Game::HandleLevelEditorInput() {
     }
 
     if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
-        sf::Vector2f vMousePosition = (sf::Vector2f)sf::Mouse::getPosition(m_Window);
+        sf::Vector2f vMousePosition = GetMouseWorldPosition();
         CreateTileAtPosition(vMousePosition);
     }
 
     if (sf::Mouse::isButtonPressed(sf::Mouse::Right)) {
-        sf::Vector2f vMousePosition = (sf::Vector2f)sf::Mouse::getPosition(m_Window);
+        sf::Vector2f vMousePosition = GetMouseWorldPosition();
         DeleteTileAtPosition(vMousePosition);
     }
 }
 
-vector<Entity>& Game::GetListOfTiles(TileOptions::TileType eTileType) {
-    switch (eTileType) {
-    case TileOptions::TileType::Aesthetic:
-        return m_AestheticTiles;
-    case TileOptions::TileType::Spawn:
-        return m_SpawnTiles;
-    case TileOptions::TileType::End:
-        return m_EndTiles;
-    case TileOptions::TileType::Path:
-        return m_PathTiles;
-    }
-    return m_AestheticTiles; // Default return if no match found
+void Game::PaintTile(TileGrid::Layer eLayer, const sf::Vector2i& vCoords, SpriteBatch& rBatch) const {
+    const TileGrid::Tile tile = m_TileGrid.Get(eLayer, vCoords);
+    if (tile.IsEmpty()) return;
+
+    const sf::Sprite& rSprite = ArchetypeRegistry::getInstanceConst().Get(m_TileOptions[tile.m_uAtlasIndex].getArchetypeId()).m_Sprite;
+    rBatch.Add(rSprite, GetGridCellCenter(vCoords), 0.0f, 0);
+}
+
+void Game::InvalidateTile(const sf::Vector2i& vCoords) {
+    // Cheaper than finding out which layer changed, a clean cell is just painted the same again
+    for (TileLayerCache& rCache : m_TileLayerCaches) {
+        rCache.Invalidate(vCoords);
+    }
+}
+
+void Game::BatchEntities(const EntityList& rEntities, int iSpriteLayer, const sf::FloatRect& rVisibleArea) {
+    for (const Entity& entity : rEntities) {
+        if (rVisibleArea.contains(entity.GetPosition())) {
+            m_SpriteBatch.Add(entity.GetArchetype().m_Sprite, entity.GetPosition(), entity.GetRotation(), iSpriteLayer);
+        }
+    }
+}
+
+void Game::UpdateCamera(sf::Time frameTime) {
+    sf::Vector2f vDirection;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A) || sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) vDirection.x -= 1.0f;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D) || sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) vDirection.x += 1.0f;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W) || sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) vDirection.y -= 1.0f;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S) || sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) vDirection.y += 1.0f;
+    m_Camera.move(vDirection * CameraPanSpeed * m_fCameraZoom * frameTime.asSeconds());
+}
+
+void Game::ZoomCamera(float fFactor, const sf::Vector2i& vPixel) {
+    const float fZoom = std::clamp(m_fCameraZoom * fFactor, MinCameraZoom, MaxCameraZoom);
+    if (fZoom == m_fCameraZoom) return;
+
+    // Keep the world position under the cursor where it is
+    const sf::Vector2f vBefore = m_Window.mapPixelToCoords(vPixel, m_Camera);
+    m_Camera.zoom(fZoom / m_fCameraZoom);
+    m_fCameraZoom = fZoom;
+    m_Camera.move(vBefore - m_Window.mapPixelToCoords(vPixel, m_Camera));
+}
+
+void Game::ResetCamera() {
+    // The first screen of the map, as it was before the camera could move
+    const sf::Vector2f vWindowSize = (sf::Vector2f)m_Window.getSize();
+    m_fCameraZoom = 1.0f;
+    m_Camera.setSize(vWindowSize);
+    m_Camera.setCenter(vWindowSize / 2.0f);
+}
+
+sf::Vector2f Game::GetMouseWorldPosition() const {
+    return m_Window.mapPixelToCoords(sf::Mouse::getPosition(m_Window), m_Camera);
+}
+
+sf::FloatRect Game::GetVisibleArea(float fMargin) const {
+    const sf::Vector2f vHalfSize = m_Camera.getSize() / 2.0f + sf::Vector2f(fMargin, fMargin);
+    return sf::FloatRect(m_Camera.getCenter() - vHalfSize, vHalfSize * 2.0f);
+}
+
+EntityList& Game::GetEntities(EntityKind eKind) {
+    switch (eKind) {
+    case EntityKind::Enemy:
+        return m_enemies;
+    case EntityKind::Axe:
+        return m_axes;
+    case EntityKind::Tower:
+        break;
+    }
+    return m_Towers;
+}
+
+const EntityList& Game::GetEntities(EntityKind eKind) const {
+    return const_cast<Game*>(this)->GetEntities(eKind);
+}
+
+Entity* Game::GetEntity(const EntityRef& rRef) {
+    return GetEntities(rRef.m_eKind).Get(rRef.m_Handle);
+}
+
+const Entity* Game::GetEntity(const EntityRef& rRef) const {
+    return GetEntities(rRef.m_eKind).Get(rRef.m_Handle);
+}
+
+EntityHandle Game::SpawnEntity(EntityKind eKind, ArchetypeRegistry::Id archetypeId, const sf::Vector2f& vPosition) {
+    EntityList& rList = GetEntities(eKind);
+    const EntityHandle handle = rList.Insert(Entity(archetypeId));
+    Entity& rEntity = *rList.Get(handle);
+    const PhysicsWorld::BodyId bodyId = m_PhysicsWorld.CreateBody(rEntity.GetArchetype().m_BodyDef, vPosition);
+    rEntity.SetBodyId(bodyId);
+    rEntity.SetPosition(vPosition);
+
+    // Contacts find their entities through this table
+    if (bodyId >= (int)m_BodyOwners.size()) {
+        m_BodyOwners.resize(bodyId + 1);
+    }
+    m_BodyOwners[bodyId] = { eKind, handle };
+
+    // Timers of the type start with the entity
+    const ArchetypeStats& rStats = rEntity.GetArchetype().m_Stats;
+    if (rStats.m_fAttackInterval > 0.0f) {
+        m_Timers.Schedule(GetTickAfter(rStats.m_fAttackInterval), { GameTimer::Kind::AttackReady, { eKind, handle } });
+    }
+    if (rStats.m_fLifetime > 0.0f) {
+        m_Timers.Schedule(GetTickAfter(rStats.m_fLifetime), { GameTimer::Kind::Expire, { eKind, handle } });
+    }
+    return handle;
+}
+
+void Game::DespawnEntityAt(EntityKind eKind, int iIndex) {
+    EntityList& rList = GetEntities(eKind);
+    m_PhysicsWorld.DestroyBody(rList[iIndex].GetBodyId());
+    // O(1), the last entity moves into this index and every handle stays valid
+    rList.RemoveAt(iIndex);
 }
 
 bool Game::CreateTowerAtPosition(const sf::Vector2f& pos) {
     if (CanPlaceTowerAtPosition(pos)) {
-        Entity newTower = m_TowerTemplate;
-        newTower.SetColor(sf::Color::White);
-        m_Towers.push_back(newTower);
+        SpawnEntity(EntityKind::Tower, m_TowerArchetype, pos);
 
         // Play tower placement sound
         SoundManager::getInstance().PlayTowerPlaceSound();
@@ -1045,36 +1309,52 @@ bool Game::CreateTowerAtPosition(const sf::Vector2f& pos) {
 }
 
 bool Game::CanPlaceTowerAtPosition(const sf::Vector2f& pos) {
-    sf::IntRect brickRect(0, 0, 16, 16);
-    vector<Entity>& ListOfTiles = GetListOfTiles(TileOptions::TileType::Aesthetic);
-    bool isOnBrick = false;
-    Entity copyOfTowerWithRadiusOf1 = m_TowerTemplate;
-    copyOfTowerWithRadiusOf1.setCirclePhysics(1.0f);
+    const sf::IntRect brickRect = m_TextureAtlas.GetRect("TileMap.png", sf::IntRect(0, 0, 16, 16));
+    const PhysicsWorld::BodyDef& rTowerBodyDef = ArchetypeRegistry::getInstanceConst().Get(m_TowerArchetype).m_BodyDef;
 
-    for (const Entity& tile : ListOfTiles) {
-        const sf::Sprite& rTileSprite = tile.GetSprite();
-        sf::IntRect tileRect = rTileSprite.getTextureRect();
+    // Towers go on brick, which is the ground tile of the cell under the position
+    const TileGrid::Tile groundTile = m_TileGrid.Get(TileGrid::Layer::Ground, GetGridCoordinates(pos));
+    if (groundTile.IsEmpty() || m_TileOptions[groundTile.m_uAtlasIndex].getSprite().getTextureRect() != brickRect) {
+        return false;
+    }
 
-        if (tileRect != brickRect) {
-            continue;
+    // Only towers near the position can overlap it
+    const float fReach = rTowerBodyDef.m_fRadius * 2;
+    m_PlacementQueryResults.clear();
+    m_PhysicsWorld.QueryStaticBodies(sf::FloatRect(pos.x - fReach, pos.y - fReach, fReach * 2, fReach * 2), PhysicsWorld::Layer::Tower, m_PlacementQueryResults);
+    for (PhysicsWorld::BodyId towerBody : m_PlacementQueryResults) {
+        if (PhysicsWorld::AreShapesOverlapping(rTowerBodyDef, m_PhysicsWorld.GetPosition(towerBody), rTowerBodyDef, pos)) {
+            return false;
         }
+    }
+    return true;
+}
 
-        if (isColiding(tile, copyOfTowerWithRadiusOf1)) {
-            isOnBrick = true;
+void Game::CycleTowerTargetingAtPosition(const sf::Vector2f& pos) {
+    m_PlacementQueryResults.clear();
+    m_PhysicsWorld.QueryStaticBodies(sf::FloatRect(pos.x - 1.0f, pos.y - 1.0f, 2.0f, 2.0f), PhysicsWorld::Layer::Tower, m_PlacementQueryResults);
+
+    Entity* pTower = nullptr;
+    for (PhysicsWorld::BodyId towerBody : m_PlacementQueryResults) {
+        if (MathHelpers::flength(m_PhysicsWorld.GetPosition(towerBody) - pos) <= GetEntity(m_BodyOwners[towerBody])->GetArchetype().m_BodyDef.m_fRadius) {
+            pTower = GetEntity(m_BodyOwners[towerBody]);
             break;
         }
     }
-
-    if (!isOnBrick) {
-        return false;
+    if (!pTower) {
+        return;
     }
 
-    for (const Entity& tower : m_Towers) {
-        if (isColiding(tower, m_TowerTemplate)) {
-            return false;
-        }
-    }
-    return true;
+    const TargetingPolicy eTargetingPolicy = (TargetingPolicy)(((int)pTower->GetTargetingPolicy() + 1) % (int)TargetingPolicy::Count);
+    pTower->SetTargetingPolicy(eTargetingPolicy);
+
+    const char* pPolicyNames[] = { "Closest", "First", "Last", "Strongest", "Weakest" };
+    static_assert(sizeof(pPolicyNames) / sizeof(pPolicyNames[0]) == (size_t)TargetingPolicy::Count, "Every targeting policy needs a name");
+    std::cout << "Tower targeting: " << pPolicyNames[(int)eTargetingPolicy] << std::endl;
+
+    // Pops up above the tower, so the policy can be seen without a console
+    const sf::Vector2f vTowerPosition = m_PhysicsWorld.GetPosition(pTower->GetBodyId());
+    DamageTextManager::getInstanceNonConst().AddText(pPolicyNames[(int)eTargetingPolicy], vTowerPosition - sf::Vector2f(0.0f, 60.0f), sf::Color::Yellow);
 }
 
 void Game::AddGold(int gold) {
@@ -1082,6 +1362,19 @@ void Game::AddGold(int gold) {
     m_iGoldGainedThisUpdate += gold;
 }
 
+void Game::SetSimulationRate(float fTicksPerSecond) {
+    // Pending timers count ticks, they have to cover the same time at the new rate
+    const sf::Time newTimeStep = sf::seconds(1.0f / fTicksPerSecond);
+    m_Timers.ScaleRemainingTicks((double)m_SimulationTimeStep.asSeconds() / newTimeStep.asSeconds());
+    m_SimulationTimeStep = newTimeStep;
+    m_SimulationAccumulator = sf::Time::Zero;
+}
+
+void Game::SetRenderFrameLimit(unsigned int uFramesPerSecond) {
+    m_uRenderFrameLimit = uFramesPerSecond;
+    m_Window.setFramerateLimit(uFramesPerSecond);
+}
+
 void Game::SetMusicVolume(float volume) {
     SoundManager::getInstance().SetMusicVolume(volume);
 }
@@ -4,8 +4,22 @@
 #include "TileOptions.h"
 #include <vector>
 #include <string>
+#include <cmath>
 #include <iostream>
+#include <future>
 #include "MenuManager.h"
+#include "PhysicsWorld.h"
+#include "JobSystem.h"
+#include "ArchetypeRegistry.h"
+#include "SpatialQuery.h"
+#include "TimerWheel.h"
+#include "PathGraph.h"
+#include "FlowField.h"
+#include "TileGrid.h"
+#include "SpriteBatch.h"
+#include "TileLayerCache.h"
+#include "TextureAtlas.h"
+#include "HudField.h"
 using namespace std;
 
 class Game {
@@ -25,9 +39,27 @@ public:
 		None
 	};
 
-	struct PathTile {
-		const Entity* pCurrentTile;
-		const Entity* pNextTile;
+	enum class EntityKind : unsigned char {
+		Tower,
+		Enemy,
+		Axe
+	};
+
+	// Which list an entity lives in plus its handle there, stays safe after the entity is gone
+	struct EntityRef {
+		EntityKind m_eKind = EntityKind::Tower;
+		EntityHandle m_Handle;
+	};
+
+	// Gameplay timer, fired by the timer wheel on the simulation tick it is due
+	struct GameTimer {
+		enum class Kind : unsigned char {
+			SpawnEnemy,
+			AttackReady, // The tower may throw again
+			Expire // The entity reached the end of its lifetime
+		};
+		Kind m_eKind = Kind::SpawnEnemy;
+		EntityRef m_Entity; // Checked when the timer fires, the entity may be gone by then
 	};
 
 	void run();
@@ -41,21 +73,36 @@ public:
 	void SetMusicVolume(float volume);
 	void SetSoundVolume(float volume);
 
+	// Gameplay always advances in steps of 1 / fTicksPerSecond, independent of the frame rate.
+	// Pending timers keep the time they have left.
+	void SetSimulationRate(float fTicksPerSecond);
+	// 0 renders as fast as possible
+	void SetRenderFrameLimit(unsigned int uFramesPerSecond);
+
 private:
 	void UpdatePlay();
+	void AdvanceTimers();
+	void OnTimer(const GameTimer& rTimer);
+	void ResetTimers();
+	// First tick at least fSeconds of simulation time from now
+	uint64_t GetTickAfter(float fSeconds) const;
 	void UpdateTower();
-	void UpdateAxe();
+	// Body of the enemy the tower shoots at, InvalidBody if none is in range
+	PhysicsWorld::BodyId SelectTarget(const Entity& rTower, const sf::Vector2f& vTowerPosition, vector<PhysicsWorld::BodyId>& rCandidates) const;
+	void ThrowAxes();
+	void UpdateEnemySteering();
+	void RemoveEnemiesAtEnd();
 	void CheckForDeletionRequest();
 	void UpdateLevelEditor();
 
 	void UpdatePhysics();
-private:
-	void ProcessCollision(Entity& entity1, Entity& entity2);
-	bool isColiding(const Entity& entity1, const Entity& entity2);
+	void ResolveCollisionEvents();
+	void SyncSpritesFromPhysics(float fAlpha);
 public:
 	void Draw();
 	void DrawMenu();
 	void DrawPlay();
+	void DrawPlayHud();
 	void DrawLevelEditor();
 
 	void HandleMenuInput(sf::Event& event);
@@ -69,52 +116,124 @@ public:
 	//Level Editor functions
 	void CreateTileAtPosition(const sf::Vector2f& pos);
 	void DeleteTileAtPosition(const sf::Vector2f& pos);
+	void UpdatePathsAfterEdit(const sf::Vector2i& vCoords, TileOptions::TileType eRemovedType, TileOptions::TileType ePlacedType);
 	void ConstructionPath();
-	vector<Entity>& GetListOfTiles(TileOptions::TileType eTileType);
+	void StartRouteSearch();
+	void FinishRouteSearch();
+	void PaintTile(TileGrid::Layer eLayer, const sf::Vector2i& vCoords, SpriteBatch& rBatch) const;
+	void InvalidateTile(const sf::Vector2i& vCoords);
+	void BatchEntities(const EntityList& rEntities, int iSpriteLayer, const sf::FloatRect& rVisibleArea);
+
+	// Camera
+	void UpdateCamera(sf::Time frameTime);
+	void ZoomCamera(float fFactor, const sf::Vector2i& vPixel);
+	void ResetCamera();
+	sf::Vector2f GetMouseWorldPosition() const;
+	// Part of the world the camera sees, grown by fMargin on every side
+	sf::FloatRect GetVisibleArea(float fMargin) const;
 
 	// Play functions
 	bool CreateTowerAtPosition(const sf::Vector2f& pos);
 	bool CanPlaceTowerAtPosition(const sf::Vector2f& pos);
+	void CycleTowerTargetingAtPosition(const sf::Vector2f& pos);
 
 	void AddGold(int gold);
 
+	// Entity lookup through handles
+	EntityList& GetEntities(EntityKind eKind);
+	const EntityList& GetEntities(EntityKind eKind) const;
+	Entity* GetEntity(const EntityRef& rRef);
+	const Entity* GetEntity(const EntityRef& rRef) const;
+	EntityHandle SpawnEntity(EntityKind eKind, ArchetypeRegistry::Id archetypeId, const sf::Vector2f& vPosition);
+	void DespawnEntityAt(EntityKind eKind, int iIndex);
+
 private:
 	sf::RenderWindow m_Window;
-	sf::Time m_deltaTime;
+	sf::Time m_deltaTime; // Always one simulation step while updating gameplay
+
+	//Fixed timestep simulation
+	sf::Time m_SimulationTimeStep;
+	sf::Time m_SimulationAccumulator;
+	int m_iMaxSubSteps; // Steps allowed per frame before the remaining time is dropped
+	size_t m_uSimulationAllocations; // Heap allocations during simulation since the last report, debug builds only
+	sf::Time m_AllocationReportTimer;
+	unsigned int m_uRenderFrameLimit; // 0 when unlimited
+
+	// Entities are drawn through one batch over the cached tile layers, bottom layer first
+	enum SpriteLayer {
+		TowerSprites,
+		EnemySprites,
+		AxeSprites
+	};
+	SpriteBatch m_SpriteBatch;
+	sf::Time m_RenderReportTimer;
+
+	// The world is drawn through the camera, text and menus through the window's default view
+	sf::View m_Camera;
+	float m_fCameraZoom; // World units per pixel
+	static constexpr float CameraPanSpeed = 1200.0f; // Pixels per second, so it feels the same at every zoom
+	static constexpr float CameraZoomStep = 1.1f;
+	static constexpr float MinCameraZoom = 0.5f;
+	static constexpr float MaxCameraZoom = 2.0f; // Further out, more tile chunks would need a texture
 	GameMode m_eGameMode;
 
+	// Every image of image/, so all gameplay sprites share a texture
+	TextureAtlas m_TextureAtlas;
+
 	//Play mode
-	sf::Texture towerTexture;
-	sf::Texture enemyTexture;
-	sf::Texture axeTexture;
 
-	Entity m_TowerTemplate;
-	vector <Entity> m_Towers;
+	// Per-type data is shared through the archetype registry, entities only keep their own state
+	ArchetypeRegistry::Id m_TowerArchetype;
+	ArchetypeRegistry::Id m_EnemyArchetype;
+	sf::Sprite m_TowerPreview; // Follows the mouse, tinted by whether a tower can be placed there
+
+	// Enemies and axes come from fixed size pools, spawning stops while a pool is full
+	static constexpr int MaxEnemies = 30;
+	static constexpr int MaxAxes = 256;
 
-	Entity m_enemyTemplate;
-	vector<Entity> m_enemies;
+	EntityList m_Towers;
+	vector<EntityHandle> m_ReadyTowers; // Towers whose attack timer fired, they stay here until they throw
+	vector<EntityHandle> m_TowerTargets; // Enemy each ready tower throws at this update, invalid when it does not throw
+	vector<vector<PhysicsWorld::BodyId>> m_TargetCandidates; // Enemies in range of a tower, one scratch buffer per job thread
 
-	Entity m_axeTemplate;
-	vector<Entity> m_axes;
+	EntityList m_enemies;
+	SpatialQuery m_EnemyQuery; // Enemy body ids by position, rebuilt every update for targeting
+	vector<char> m_EnemyReachedEnd; // char, not bool, so jobs can write neighbouring entries
+
+	EntityList m_axes;
 
 	//vector <Entity*> m_AllEntities;
 
+	// Every gameplay timer, only the timers due in a tick are touched. Not thread safe, it is
+	// only used by the main thread and the serial job that throws the axes.
+	TimerWheel<GameTimer> m_Timers;
+
+	//Jobs
+	JobSystem m_JobSystem;
+
+	//Physics
+	PhysicsWorld m_PhysicsWorld;
+	vector<EntityRef> m_BodyOwners; // Indexed by body id, set when the body is created
+	vector<PhysicsWorld::BodyId> m_PlacementQueryResults;
+	CollisionEventQueue m_CollisionEvents;
+	vector<CollisionEventQueue::Event> m_ResolvedEvents;
+
 	sf::Text m_GameModeText;
 	sf::Font m_Font;
-	sf::Text m_PlayerText;
+	// Player stats, each only laid out again when its shown value changes
+	HudField m_DifficultyHud;
+	HudField m_GoldHud;
+	HudField m_GoldPerSecondHud;
 	sf::Text m_GameOverText;
 
 	//Level Editor Mode
 	int m_optionIndex;
 	ScrollWheel m_eScrollWheelInput;
 
-	sf::Texture m_TileMapTexture;
 	// TODO: these need to be entities, not sprites
 	vector <TileOptions> m_TileOptions;
-	vector <Entity> m_AestheticTiles;
-	vector <Entity> m_SpawnTiles;
-	vector <Entity> m_EndTiles;
-	vector <Entity> m_PathTiles;
+	TileGrid m_TileGrid; // Atlas indices are indices into m_TileOptions
+	TileLayerCache m_TileLayerCaches[(int)TileGrid::Layer::Count]; // Only repainted where a tile was created or deleted
 
 	bool m_bDrawPath;
 
@@ -136,12 +255,31 @@ private:
 
 private:
 	//PathFinding
-	typedef vector<PathTile> Path;
+	// Alternative routes enemies pick from, shortest first, through the centres of their tiles
+	static constexpr int MaxPaths = 8;
+	vector<RoutePolyline> m_Paths;
+
+	PathGraph m_PathGraph; // Spawn, end and path tiles, updated whenever a tile changes
+	FlowField m_FlowField; // Towards the end tile, for enemies left without a route after an edit
+	static constexpr int FlowFieldMargin = 1;
+
+	// Routes are searched on a copy of the graph in the background, so dragging in the editor does not stall
+	struct RouteSearchResult {
+		vector<RoutePolyline> m_Paths;
+		int m_iNodeCount = 0;
+		float m_fMilliseconds = 0.0f;
+	};
+	static RouteSearchResult FindRoutes(const PathGraph& rGraph, const sf::Vector2i& vSpawn, const sf::Vector2i& vEnd);
+	std::future<RouteSearchResult> m_RouteSearch;
+	bool m_bRouteSearchOutdated = false; // The map changed after the running search started
 
-	void VisitPathNeighbors(Path path, const sf::Vector2i& rEndCoords);
-	bool DoesPathContainCoordinates(const Path& path, const sf::Vector2i& coordinates);
+	static sf::Vector2i GetGridCoordinates(const sf::Vector2f& vPosition) {
+		return sf::Vector2i((int)std::floor(vPosition.x / 160), (int)std::floor(vPosition.y / 160));
+	}
 
-	vector<Path> m_Paths;
+	static sf::Vector2f GetGridCellCenter(const sf::Vector2i& vCoords) {
+		return sf::Vector2f(vCoords.x * 160.0f + 80.0f, vCoords.y * 160.0f + 80.0f);
+	}
 
 	// Menu manager
 	MenuManager m_MenuManager;